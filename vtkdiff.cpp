@@ -7,27 +7,74 @@
  */
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
 #include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <future>
 #include <iomanip>
 #include <ios>
 #include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <random>
 #include <sstream>
+#include <string>
+#include <thread>
 #include <tuple>
 #include <type_traits>
+#include <variant>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
 
 #include <tclap/CmdLine.h>
 
 #include <vtkCellArray.h>
 #include <vtkCellData.h>
+#include <vtkCellType.h>
 #include <vtkCommand.h>
 #include <vtkDataArray.h>
 #include <vtkDoubleArray.h>
+#include <vtkFloatArray.h>
+#include <vtkIdList.h>
+#include <vtkMath.h>
 #include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkSOADataArrayTemplate.h>
 #include <vtkSmartPointer.h>
 #include <vtkUnstructuredGrid.h>
 #include <vtkVersion.h>
 #include <vtkXMLUnstructuredGridReader.h>
+#include <vtkXMLUnstructuredGridWriter.h>
+#if VTK_MAJOR_VERSION > 9 || (VTK_MAJOR_VERSION == 9 && VTK_MINOR_VERSION >= 3)
+#include <vtkConstantArray.h>
+#endif
 
 template <typename T>
 auto float_to_string(T const& v) -> std::string
@@ -50,6 +97,48 @@ bool stringEndsWith(std::string const& str, std::string const& ending)
     return str.compare(string_end_length, ending.length(), ending) == 0;
 }
 
+/// Parses a whole string, up to surrounding white space, as a floating point
+/// number without throwing. Subnormal values are accepted, values
+/// overflowing a double are not.
+std::optional<double> parseDouble(std::string const& str)
+{
+    char const* const begin = str.c_str();
+    char* end = nullptr;
+    errno = 0;
+    double const value = std::strtod(begin, &end);
+    if (end == begin || (errno == ERANGE && std::abs(value) == HUGE_VAL))
+    {
+        return std::nullopt;
+    }
+    while (std::isspace(static_cast<unsigned char>(*end)))
+        ++end;
+    if (*end != '\0')
+    {
+        return std::nullopt;
+    }
+    return value;
+}
+
+/// Parses a whole string, up to surrounding white space, as an integer in
+/// the given base without throwing.
+template <typename T>
+std::optional<T> parseInteger(std::string const& str, int const base = 10)
+{
+    auto const* begin = str.data();
+    auto const* end = str.data() + str.size();
+    while (begin < end && std::isspace(static_cast<unsigned char>(*begin)))
+        ++begin;
+    while (begin < end && std::isspace(static_cast<unsigned char>(end[-1])))
+        --end;
+    T value;
+    auto const [last, error] = std::from_chars(begin, end, value, base);
+    if (error != std::errc{} || last != end || begin == end)
+    {
+        return std::nullopt;
+    }
+    return value;
+}
+
 template <typename T>
 std::ostream& operator<<(std::ostream& os, std::vector<T> const& vector)
 {
@@ -68,13 +157,583 @@ std::ostream& operator<<(std::ostream& os, std::vector<T> const& vector)
     return os << vector.back() << "]";
 }
 
+/// 64 bit non-cryptographic hash of a byte range (XXH64).
+std::uint64_t hashBytes(void const* const data, std::size_t const size,
+                        std::uint64_t const seed = 0)
+{
+    constexpr std::uint64_t p1 = 0x9E3779B185EBCA87ULL;
+    constexpr std::uint64_t p2 = 0xC2B2AE3D27D4EB4FULL;
+    constexpr std::uint64_t p3 = 0x165667B19E3779F9ULL;
+    constexpr std::uint64_t p4 = 0x85EBCA77C2B2AE63ULL;
+    constexpr std::uint64_t p5 = 0x27D4EB2F165667C5ULL;
+
+    auto const rotl = [](std::uint64_t x, int r) {
+        return (x << r) | (x >> (64 - r));
+    };
+    auto const round = [&](std::uint64_t acc, std::uint64_t input) {
+        acc += input * p2;
+        return rotl(acc, 31) * p1;
+    };
+    auto const merge_round = [&](std::uint64_t acc, std::uint64_t value) {
+        acc ^= round(0, value);
+        return acc * p1 + p4;
+    };
+    auto const read64 = [](unsigned char const* p) {
+        std::uint64_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    };
+    auto const read32 = [](unsigned char const* p) {
+        std::uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return static_cast<std::uint64_t>(v);
+    };
+
+    auto const* p = static_cast<unsigned char const*>(data);
+    auto const* const end = p + size;
+
+    std::uint64_t h;
+    if (size >= 32)
+    {
+        std::uint64_t v1 = seed + p1 + p2;
+        std::uint64_t v2 = seed + p2;
+        std::uint64_t v3 = seed;
+        std::uint64_t v4 = seed - p1;
+        for (; p + 32 <= end; p += 32)
+        {
+            v1 = round(v1, read64(p));
+            v2 = round(v2, read64(p + 8));
+            v3 = round(v3, read64(p + 16));
+            v4 = round(v4, read64(p + 24));
+        }
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = merge_round(h, v1);
+        h = merge_round(h, v2);
+        h = merge_round(h, v3);
+        h = merge_round(h, v4);
+    }
+    else
+    {
+        h = seed + p5;
+    }
+
+    h += static_cast<std::uint64_t>(size);
+    for (; p + 8 <= end; p += 8)
+    {
+        h ^= round(0, read64(p));
+        h = rotl(h, 27) * p1 + p4;
+    }
+    if (p + 4 <= end)
+    {
+        h ^= read32(p) * p1;
+        h = rotl(h, 23) * p2 + p3;
+        p += 4;
+    }
+    for (; p < end; ++p)
+    {
+        h ^= (*p) * p5;
+        h = rotl(h, 11) * p1;
+    }
+
+    h ^= h >> 33;
+    h *= p2;
+    h ^= h >> 29;
+    h *= p3;
+    h ^= h >> 32;
+    return h;
+}
+
+/// Hashes a file's content in blocks of 4 MiB, which are read and hashed
+/// concurrently; the result is the hash of the sequence of block hashes.
+/// Returns nothing if the file cannot be read.
+std::optional<std::uint64_t> hashFile(std::string const& filename)
+{
+    constexpr std::uint64_t block_size = 4 << 20;
+
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file)
+    {
+        return std::nullopt;
+    }
+    auto const file_size = static_cast<std::uint64_t>(file.tellg());
+    file.close();
+
+    std::uint64_t const n_blocks = (file_size + block_size - 1) / block_size;
+    std::vector<std::uint64_t> block_hashes(n_blocks);
+    std::atomic<std::uint64_t> next_block{0};
+    std::atomic<bool> failed{false};
+
+    auto const hash_blocks = [&]() {
+        std::ifstream block_file(filename, std::ios::binary);
+        std::vector<char> buffer(block_size);
+        for (auto block = next_block++; block < n_blocks; block = next_block++)
+        {
+            auto const size =
+                std::min(block_size, file_size - block * block_size);
+            block_file.seekg(block * block_size);
+            if (!block_file.read(buffer.data(), size))
+            {
+                failed = true;
+                return;
+            }
+            block_hashes[block] = hashBytes(buffer.data(), size);
+        }
+    };
+
+    auto const n_threads = std::min<std::uint64_t>(
+        std::max(1u, std::thread::hardware_concurrency()), n_blocks);
+    std::vector<std::thread> threads;
+    for (std::uint64_t t = 1; t < n_threads; ++t)
+    {
+        threads.emplace_back(hash_blocks);
+    }
+    hash_blocks();
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    if (failed)
+    {
+        return std::nullopt;
+    }
+    return hashBytes(block_hashes.data(),
+                     block_hashes.size() * sizeof(std::uint64_t));
+}
+
+std::string toHexString(std::uint64_t const value)
+{
+    std::stringstream sstream;
+    sstream << std::hex << std::setw(16) << std::setfill('0') << value;
+    return sstream.str();
+}
+
+/// Limit of the number of worker threads; 0 for one per hardware thread.
+unsigned& threadLimit()
+{
+    static unsigned limit = 0;
+    return limit;
+}
+
+/// Number of worker threads used by the parallel passes.
+unsigned numberOfThreads()
+{
+    if (threadLimit() > 0)
+        return threadLimit();
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/// Calls f(chunk, begin, end) for the consecutive chunks [begin, end) of
+/// [0, n), distributing the chunks over the worker threads. Callers make
+/// their results independent of the thread count by storing them per chunk.
+template <typename Function>
+void parallelForChunks(std::int64_t const n, std::int64_t const chunk_size,
+                       Function const& f)
+{
+    std::int64_t const n_chunks = (n + chunk_size - 1) / chunk_size;
+    std::atomic<std::int64_t> next_chunk{0};
+
+    auto const work = [&]() {
+        for (auto chunk = next_chunk++; chunk < n_chunks; chunk = next_chunk++)
+        {
+            f(chunk, chunk * chunk_size, std::min(n, (chunk + 1) * chunk_size));
+        }
+    };
+
+    auto const n_threads =
+        std::min<std::int64_t>(numberOfThreads(), n_chunks);
+    std::vector<std::thread> threads;
+    for (std::int64_t t = 1; t < n_threads; ++t)
+    {
+        threads.emplace_back(work);
+    }
+    work();
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+/// Chunk size of the parallel passes over points and cells.
+constexpr std::int64_t mesh_chunk_size = 1 << 16;
+
+/// Hardware performance counters of the thread opening them, including the
+/// threads it starts while they are open, but not threads running already.
+/// Counters the kernel does not permit, e.g. in containers, are left out.
+class PerfCounters
+{
+public:
+    static constexpr std::size_t size = 4;
+    static constexpr std::array<char const*, size> names{
+        {"cycles", "instructions", "LLC misses", "dTLB misses"}};
+
+    /// Counters opened by main() for --timings, telling whether and which
+    /// counters are available. Phases are measured by their own counters.
+    static PerfCounters& instance()
+    {
+        static PerfCounters counters;
+        return counters;
+    }
+
+    PerfCounters() = default;
+    PerfCounters(PerfCounters const&) = delete;
+    PerfCounters& operator=(PerfCounters const&) = delete;
+
+    ~PerfCounters()
+    {
+#ifdef __linux__
+        for (int const fd : _fds)
+        {
+            if (fd >= 0)
+                ::close(fd);
+        }
+#endif
+    }
+
+    /// Opens the counters. Returns true if at least one is available.
+    bool open()
+    {
+#ifdef __linux__
+        auto const cache_miss = [](std::uint64_t const cache) {
+            return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                   (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        };
+        std::array<std::tuple<std::uint32_t, std::uint64_t>, size> const
+            events{{{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+                    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+                    {PERF_TYPE_HW_CACHE, cache_miss(PERF_COUNT_HW_CACHE_LL)},
+                    {PERF_TYPE_HW_CACHE,
+                     cache_miss(PERF_COUNT_HW_CACHE_DTLB)}}};
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            perf_event_attr attr{};
+            attr.size = sizeof(attr);
+            std::tie(attr.type, attr.config) = events[i];
+            attr.inherit = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            _fds[i] = static_cast<int>(
+                syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+#endif
+        _enabled = available(0) || available(1) || available(2) ||
+                   available(3);
+        return _enabled;
+    }
+
+    bool enabled() const { return _enabled; }
+    bool available(std::size_t const i) const { return _fds[i] >= 0; }
+
+    /// Current counts, including those of the threads started since opening.
+    std::array<std::uint64_t, size> read() const
+    {
+        std::array<std::uint64_t, size> values{};
+#ifdef __linux__
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            if (_fds[i] >= 0 &&
+                ::read(_fds[i], &values[i], sizeof(values[i])) !=
+                    sizeof(values[i]))
+            {
+                values[i] = 0;
+            }
+        }
+#endif
+        return values;
+    }
+
+private:
+    std::array<int, size> _fds{{-1, -1, -1, -1}};
+    bool _enabled = false;
+};
+
+/// Wall time, hardware counts and bytes processed in one phase of the run,
+/// summed over all its occurrences. Reads on other threads, like the next
+/// step of a time series read while comparing, are timed only as far as the
+/// main thread waits for them, so that the phases do not overlap; their
+/// hardware counts are measured on the reading threads.
+struct PhaseStatistics
+{
+    std::atomic<std::int64_t> nanoseconds{0};
+    std::atomic<std::uint64_t> bytes{0};
+    std::array<std::atomic<std::uint64_t>, PerfCounters::size> counts{};
+
+    /// Sets the statistics to those of other, e.g. to restore a snapshot.
+    void assign(PhaseStatistics const& other)
+    {
+        nanoseconds = other.nanoseconds.load();
+        bytes = other.bytes.load();
+        for (std::size_t i = 0; i < counts.size(); ++i)
+            counts[i] = other.counts[i].load();
+    }
+};
+
+/// Counters of the work done, updated with relaxed atomics once per file
+/// progress event or chunk and printed periodically by a ProgressReporter.
+/// The totals grow as further files and arrays are started. The times spent
+/// reading and comparing are summed over all files and arrays.
+struct Progress
+{
+    static Progress& instance()
+    {
+        static Progress progress;
+        return progress;
+    }
+
+    std::atomic<bool> enabled{false};
+    std::atomic<std::uint64_t> bytes_total{0};
+    std::atomic<std::uint64_t> bytes_read{0};
+    std::atomic<std::int64_t> tuples_total{0};
+    std::atomic<std::int64_t> tuples_compared{0};
+    PhaseStatistics decode;
+    PhaseStatistics compare;
+
+    /// Sets the counters to those of other, e.g. to restore a snapshot.
+    void assign(Progress const& other)
+    {
+        bytes_total = other.bytes_total.load();
+        bytes_read = other.bytes_read.load();
+        tuples_total = other.tuples_total.load();
+        tuples_compared = other.tuples_compared.load();
+        decode.assign(other.decode);
+        compare.assign(other.compare);
+    }
+};
+
+/// Adds the time and hardware counts from construction to destruction to
+/// the statistics of a phase. The counts are those of the constructing
+/// thread and of the threads it starts meanwhile. The wall time is left out
+/// if it is measured by a waiting thread instead.
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(PhaseStatistics& phase, bool const wall_time = true)
+        : _phase(phase), _wall_time(wall_time)
+    {
+        if (PerfCounters::instance().enabled())
+        {
+            _counters.emplace();
+            _counters->open();
+            _counts = _counters->read();
+        }
+    }
+
+    ~ScopedTimer()
+    {
+        if (_wall_time)
+        {
+            _phase.nanoseconds +=
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - _start)
+                    .count();
+        }
+        if (_counters)
+        {
+            auto const counts = _counters->read();
+            for (std::size_t i = 0; i < counts.size(); ++i)
+                _phase.counts[i] += counts[i] - _counts[i];
+        }
+    }
+
+private:
+    PhaseStatistics& _phase;
+    bool const _wall_time;
+    std::optional<PerfCounters> _counters;
+    std::array<std::uint64_t, PerfCounters::size> _counts{};
+    std::chrono::steady_clock::time_point const _start =
+        std::chrono::steady_clock::now();
+};
+
+/// Prints the progress counters with rates and an estimated remaining time
+/// to stderr every second while it exists, and once more at its end. The
+/// output bypasses std::cerr and is never stored in the result cache.
+class ProgressReporter
+{
+public:
+    ProgressReporter()
+    {
+        Progress::instance().enabled = true;
+        _thread = std::thread([this]() {
+            std::unique_lock<std::mutex> lock(_mutex);
+            while (!_stopped.wait_for(lock, std::chrono::seconds(1),
+                                      [this]() { return _stop; }))
+            {
+                report();
+            }
+        });
+    }
+
+    ~ProgressReporter()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _stopped.notify_one();
+        _thread.join();
+        report();
+        Progress::instance().enabled = false;
+    }
+
+private:
+    void report() const
+    {
+        auto const& progress = Progress::instance();
+        auto const relaxed = std::memory_order_relaxed;
+        double const bytes_total = progress.bytes_total.load(relaxed);
+        double const bytes_read = progress.bytes_read.load(relaxed);
+        double const tuples_total = progress.tuples_total.load(relaxed);
+        double const tuples = progress.tuples_compared.load(relaxed);
+        double const seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                          _start)
+                .count();
+
+        double const mib = 1024. * 1024.;
+        double const byte_rate = seconds > 0 ? bytes_read / seconds : 0;
+        double const tuple_rate = seconds > 0 ? tuples / seconds : 0;
+        double eta = 0;
+        if (byte_rate > 0)
+            eta += (bytes_total - bytes_read) / byte_rate;
+        if (tuple_rate > 0)
+            eta += (tuples_total - tuples) / tuple_rate;
+
+        std::fprintf(stderr,
+                     "progress: %.1f s, read %.1f of %.1f MiB (%.1f MiB/s), "
+                     "compared %.0f of %.0f tuples (%.3g tuples/s), "
+                     "ETA %.0f s\n",
+                     seconds, bytes_read / mib, bytes_total / mib,
+                     byte_rate / mib, tuples, tuples_total, tuple_rate, eta);
+    }
+
+    std::chrono::steady_clock::time_point const _start =
+        std::chrono::steady_clock::now();
+    std::mutex _mutex;
+    std::condition_variable _stopped;
+    bool _stop = false;
+    std::thread _thread;
+};
+
+/// Parses a component selection like "2", "0-3" or "0,4-5" into the sorted
+/// component indices. Returns nothing if the string is not valid.
+std::optional<std::vector<int>> parseComponents(std::string const& str)
+{
+    std::vector<int> components;
+    std::stringstream ss(str);
+    std::string item;
+    while (std::getline(ss, item, ','))
+    {
+        auto const dash = item.find('-');
+        int first, last;
+        try
+        {
+            std::size_t end;
+            first = std::stoi(item.substr(0, dash), &end);
+            if (end != dash && end != item.size())
+                return std::nullopt;
+            last = first;
+            if (dash != std::string::npos)
+            {
+                auto const last_str = item.substr(dash + 1);
+                last = std::stoi(last_str, &end);
+                if (end != last_str.size())
+                    return std::nullopt;
+            }
+        }
+        catch (std::exception const&)
+        {
+            return std::nullopt;
+        }
+        if (first < 0 || last < first)
+        {
+            return std::nullopt;
+        }
+        for (int c = first; c <= last; ++c)
+            components.push_back(c);
+    }
+    if (components.empty())
+    {
+        return std::nullopt;
+    }
+    std::sort(components.begin(), components.end());
+    components.erase(std::unique(components.begin(), components.end()),
+                     components.end());
+    return components;
+}
+
+/// Parses a memory size like "512M" or "4G" into bytes. Returns 0 if the
+/// string is not a valid size.
+std::uint64_t parseMemorySize(std::string const& str)
+{
+    std::size_t end = 0;
+    double value;
+    try
+    {
+        value = std::stod(str, &end);
+    }
+    catch (std::exception const&)
+    {
+        return 0;
+    }
+
+    auto suffix = str.substr(end);
+    if (!suffix.empty() && std::toupper(suffix.back()) == 'B')
+        suffix.pop_back();
+    if (!suffix.empty() && suffix.back() == 'i')
+        suffix.pop_back();
+
+    double factor = 1;
+    if (suffix.empty())
+        factor = 1;
+    else if (suffix.size() == 1 && std::toupper(suffix[0]) == 'K')
+        factor = 1024.;
+    else if (suffix.size() == 1 && std::toupper(suffix[0]) == 'M')
+        factor = 1024. * 1024.;
+    else if (suffix.size() == 1 && std::toupper(suffix[0]) == 'G')
+        factor = 1024. * 1024. * 1024.;
+    else if (suffix.size() == 1 && std::toupper(suffix[0]) == 'T')
+        factor = 1024. * 1024. * 1024. * 1024.;
+    else
+        return 0;
+
+    if (!(value > 0))
+        return 0;
+    return static_cast<std::uint64_t>(value * factor);
+}
+
 struct Args
 {
     bool const quiet;
     bool const verbose;
     bool const meshcheck;
+    int const mesh_report;
+    bool const canonical_node_order;
+    double const mesh_rel_thr;
+    std::string const mesh_rel_scale;
     double const abs_err_thr;
     double const rel_err_thr;
+    std::uint64_t const max_memory;
+    bool const shm_cache;
+    std::string const result_cache;
+    bool const cross_association;
+    std::vector<std::string> const ensemble;
+    std::string const ensemble_output;
+    bool const bits;
+    /// Compared components; all if empty.
+    std::vector<int> const components;
+    bool const progress;
+    std::string const metrics_file;
+    bool const timings;
+    bool const roofline;
+    int const repeat;
+    std::string const io;
+    bool const match_order;
+    std::string const permutation_cache;
+    std::string const write_signature;
+    std::string const against_signature;
+    bool const index;
+    bool const evict_page_cache;
+    bool const header_check;
     std::string const vtk_input_a;
     std::string const vtk_input_b;
     std::string const data_array_a;
@@ -124,7 +783,118 @@ auto parseCommandLine(int argc, char* argv[]) -> Args
 
     TCLAP::SwitchArg meshcheck_arg(
         "m", "mesh_check", "Compare mesh geometries using absolute tolerance.");
-    cmd.xorAdd(data_array_a_arg, meshcheck_arg);
+
+    TCLAP::SwitchArg index_arg(
+        "",
+        "index",
+        "Instead of comparing, scan the headers of the .vtu files in the "
+        "directory given as first input in parallel and write a catalog of "
+        "their data arrays: association, type, components, tuples, payload "
+        "position, encoding, compressed blocks and payload hash. While a "
+        "file is unchanged, comparisons use the catalog instead of scanning "
+        "its header and skip decoding arrays with identical payloads.");
+    std::vector<TCLAP::Arg*> mode_args{&data_array_a_arg, &meshcheck_arg,
+                                       &index_arg};
+    cmd.xorAdd(mode_args);
+
+    TCLAP::ValueArg<int> mesh_report_arg(
+        "",
+        "mesh-report",
+        "Check all points and cells in the mesh comparison instead of stopping "
+        "at the first mismatch. Reports the numbers of mismatching points and "
+        "cells, the first N mismatches of each, and the maximum point "
+        "distance.",
+        false,
+        0,
+        "N");
+    cmd.add(mesh_report_arg);
+
+    TCLAP::SwitchArg canonical_node_order_arg(
+        "",
+        "canonical-node-order",
+        "Compare cells independent of their starting node: cells whose node "
+        "orders differ by a rotation of the cell keeping its orientation, "
+        "and polyhedra whose faces are listed in a different order, are "
+        "equal.");
+    cmd.add(canonical_node_order_arg);
+
+    TCLAP::ValueArg<double> mesh_rel_thr_arg(
+        "",
+        "mesh-rel",
+        "Relative tolerance for the point distances in the mesh check, "
+        "scaled by the length selected with --mesh-rel-scale. The absolute "
+        "tolerance applies where it is larger.",
+        false,
+        0,
+        "FLOAT");
+    cmd.add(mesh_rel_thr_arg);
+
+    std::vector<std::string> mesh_rel_scales{"bbox", "edge"};
+    TCLAP::ValuesConstraint<std::string> mesh_rel_scales_constraint(
+        mesh_rel_scales);
+    TCLAP::ValueArg<std::string> mesh_rel_scale_arg(
+        "",
+        "mesh-rel-scale",
+        "Length scale of --mesh-rel: the bounding box diagonal of the first "
+        "mesh, or the shortest edge at each point of the first mesh (bbox).",
+        false,
+        "bbox",
+        &mesh_rel_scales_constraint);
+    cmd.add(mesh_rel_scale_arg);
+
+    std::vector<std::string> io_backends{"buffered", "mmap", "pread",
+                                         "direct"};
+    TCLAP::ValuesConstraint<std::string> io_backends_constraint(io_backends);
+    TCLAP::ValueArg<std::string> io_arg(
+        "",
+        "io",
+        "How input files are read: by VTK's buffered file stream, through a "
+        "memory mapping, by parallel pread() calls, or by parallel O_DIRECT "
+        "reads bypassing the page cache (buffered).",
+        false,
+        "buffered",
+        &io_backends_constraint);
+    cmd.add(io_arg);
+
+    TCLAP::SwitchArg match_order_arg(
+        "",
+        "match-order",
+        "Compare data arrays of meshes whose points and cells are stored in "
+        "different orders. Points are matched within the tolerance of the "
+        "mesh check, cells by their type and points.");
+    cmd.add(match_order_arg);
+
+    TCLAP::ValueArg<std::string> permutation_cache_arg(
+        "",
+        "permutation-cache",
+        "Directory storing the point and cell permutations computed by "
+        "--match-order for reuse by later runs.",
+        false,
+        "",
+        "DIR");
+    cmd.add(permutation_cache_arg);
+
+    TCLAP::ValueArg<std::string> write_signature_arg(
+        "",
+        "write-signature",
+        "Write a signature of the data arrays of the first file to this "
+        "file instead of comparing: counts, norms, moments, quantiles, "
+        "minimum, maximum and mean of blocks of tuples, and hashes.",
+        false,
+        "",
+        "PATH");
+    cmd.add(write_signature_arg);
+
+    TCLAP::ValueArg<std::string> against_signature_arg(
+        "",
+        "against-signature",
+        "Compare the data array of the first file to its signature written by "
+        "--write-signature instead of to a second file. Fails if the "
+        "signatures imply errors larger than the thresholds.",
+        false,
+        "",
+        "PATH");
+    cmd.add(against_signature_arg);
 
     TCLAP::SwitchArg quiet_arg("q", "quiet", "Suppress all but error output.");
     cmd.add(quiet_arg);
@@ -156,309 +926,6433 @@ auto parseCommandLine(int argc, char* argv[]) -> Args
         "FLOAT");
     cmd.add(rel_err_thr_arg);
 
-    cmd.parse(argc, argv);
-
-    return Args{quiet_arg.getValue(),       verbose_arg.getValue(),
-                meshcheck_arg.getValue(),   abs_err_thr_arg.getValue(),
-                rel_err_thr_arg.getValue(), vtk_input_a_arg.getValue(),
-                vtk_input_b_arg.getValue(), data_array_a_arg.getValue(),
-                data_array_b_arg.getValue()};
-}
+    TCLAP::ValueArg<std::string> max_memory_arg(
+        "",
+        "max-memory",
+        "Refuse to read the input files if their estimated memory footprint, "
+        "computed from the file headers, exceeds this budget. Accepts the "
+        "suffixes K, M, G and T (powers of 1024).",
+        false,
+        "",
+        "SIZE");
+    cmd.add(max_memory_arg);
 
-template <typename T>
-class ErrorCallback : public vtkCommand
-{
-public:
-    vtkTypeMacro(ErrorCallback, vtkCommand);
+    TCLAP::SwitchArg shm_cache_arg(
+        "",
+        "shm-cache",
+        "Share decoded data arrays between concurrently running vtkdiff "
+        "processes through POSIX shared memory, keyed by the input files' "
+        "content hashes. Segments of processes which were killed stay in "
+        "/dev/shm/vtkdiff-* until they are removed by hand.");
+    cmd.add(shm_cache_arg);
 
-    static ErrorCallback<T>* New() { return new ErrorCallback<T>; }
+    TCLAP::ValueArg<std::string> result_cache_arg(
+        "",
+        "result-cache",
+        "Directory storing the output, exit code and metrics of comparisons. "
+        "A comparison of inputs with the same content hashes and the same "
+        "options is answered from the cache; the bytes read, times and "
+        "tuples compared of --metrics-file are those of the answering run.",
+        false,
+        "",
+        "DIR");
+    cmd.add(result_cache_arg);
 
-    void Execute(vtkObject* caller, unsigned long vtkNotUsed(eventId),
-                 void* callData) override
-    {
-        auto* reader = static_cast<T*>(caller);
-        std::cerr << "Error reading file `" << reader->GetFileName() << "'\n"
-                  << static_cast<char*>(callData) << "\nAborting." << std::endl;
-        std::exit(2);
-    }
-};
+    TCLAP::SwitchArg cross_association_arg(
+        "",
+        "cross-association",
+        "If the second data array is not found with the association (point "
+        "or cell data) of the first one, use it with the other association "
+        "and convert it by averaging over the adjacent cells or points.");
+    cmd.add(cross_association_arg);
 
-vtkSmartPointer<vtkUnstructuredGrid> readMesh(std::string const& filename)
-{
-    if (filename.empty())
-    {
-        return nullptr;
-    }
+    TCLAP::MultiArg<std::string> ensemble_arg(
+        "e",
+        "ensemble",
+        "Further run of an ensemble, may be repeated. The input files and "
+        "these runs are read one at a time to compute the per-value mean, "
+        "standard deviation, minimum and maximum of the first data array. "
+        "Fails if the spread exceeds both thresholds.",
+        false,
+        "VTK FILE");
+    cmd.add(ensemble_arg);
 
-    if (!stringEndsWith(filename, ".vtu"))
-    {
-        std::cerr << "Error: Expected a file with .vtu extension."
-                  << "File '" << filename << "' not read.";
-        return nullptr;
-    }
+    TCLAP::ValueArg<std::string> ensemble_output_arg(
+        "",
+        "ensemble-output",
+        "Write the ensemble's mean, standard deviation, minimum and maximum "
+        "fields on the mesh of the first input file to this .vtu file.",
+        false,
+        "",
+        "VTK FILE");
+    cmd.add(ensemble_output_arg);
 
-    vtkSmartPointer<ErrorCallback<vtkXMLUnstructuredGridReader>> errorCallback =
-        vtkSmartPointer<ErrorCallback<vtkXMLUnstructuredGridReader>>::New();
+    TCLAP::SwitchArg bits_arg(
+        "",
+        "bits",
+        "Report per component how many values are bit-identical, how many "
+        "differ in sign or exponent, and the distribution of the highest "
+        "differing mantissa bit.");
+    cmd.add(bits_arg);
+
+    TCLAP::ValueArg<std::string> components_arg(
+        "",
+        "components",
+        "Compare only these components of the data arrays, given as indices "
+        "and ranges like `2', `0-3' or `0,4-5'.",
+        false,
+        "",
+        "COMPONENTS");
+    cmd.add(components_arg);
+
+    TCLAP::SwitchArg progress_arg(
+        "",
+        "progress",
+        "Print the bytes read and tuples compared with rates and an "
+        "estimated remaining time to stderr every second.");
+    cmd.add(progress_arg);
+
+    TCLAP::ValueArg<std::string> metrics_file_arg(
+        "",
+        "metrics-file",
+        "Write the bytes read, decode and compare times, throughput, peak "
+        "memory, maximum errors per array and the result in OpenMetrics text "
+        "format to this file, e.g. for node_exporter's textfile collector.",
+        false,
+        "",
+        "PATH");
+    cmd.add(metrics_file_arg);
+
+    TCLAP::SwitchArg timings_arg(
+        "",
+        "timings",
+        "Print the wall time of the read and compare phases and, on Linux if "
+        "permitted, their cycles, instructions, LLC and dTLB misses, "
+        "instructions per cycle and bytes per cycle. Both input files, or "
+        "the next step of a time series or ensemble, are read concurrently, "
+        "but each file is decoded by a single thread; the read phase is the "
+        "time spent waiting for them.");
+    cmd.add(timings_arg);
+
+    TCLAP::SwitchArg roofline_arg(
+        "",
+        "roofline",
+        "After the comparison, measure the memory bandwidth with a built-in "
+        "probe and the bandwidth of the compare kernel for increasing "
+        "numbers of threads, and print the kernel's fraction of the "
+        "memory bandwidth.");
+    cmd.add(roofline_arg);
+
+    TCLAP::ValueArg<int> repeat_arg(
+        "",
+        "repeat",
+        "Run the whole comparison this many times and print the minimum, "
+        "median and maximum time of the read and compare phases. Only the "
+        "first run prints its output and counts in --timings and "
+        "--metrics-file; its exit code is returned.",
+        false,
+        1,
+        "N");
+    cmd.add(repeat_arg);
+
+    TCLAP::SwitchArg evict_page_cache_arg(
+        "",
+        "evict-page-cache",
+        "With --repeat, evict the input files from the operating system's "
+        "page cache before each run to measure reading them from disk.");
+    cmd.add(evict_page_cache_arg);
+
+    TCLAP::SwitchArg no_header_check_arg(
+        "",
+        "no-header-check",
+        "Do not check the data arrays' counts and value ranges given in the "
+        "file headers before decoding the data.");
+    cmd.add(no_header_check_arg);
+
+    cmd.parse(argc, argv);
+
+    std::uint64_t max_memory = 0;
+    if (max_memory_arg.isSet())
+    {
+        max_memory = parseMemorySize(max_memory_arg.getValue());
+        if (max_memory == 0)
+        {
+            std::cerr << "Error: Could not parse memory size `"
+                      << max_memory_arg.getValue() << "'.\n";
+            std::exit(EXIT_FAILURE);
+        }
+    }
+
+    std::vector<int> components;
+    if (components_arg.isSet())
+    {
+        auto const parsed = parseComponents(components_arg.getValue());
+        if (!parsed)
+        {
+            std::cerr << "Error: Could not parse components `"
+                      << components_arg.getValue() << "'.\n";
+            std::exit(EXIT_FAILURE);
+        }
+        components = *parsed;
+    }
+
+    return Args{quiet_arg.getValue(),
+                verbose_arg.getValue(),
+                meshcheck_arg.getValue(),
+                mesh_report_arg.getValue(),
+                canonical_node_order_arg.getValue(),
+                mesh_rel_thr_arg.getValue(),
+                mesh_rel_scale_arg.getValue(),
+                abs_err_thr_arg.getValue(),
+                rel_err_thr_arg.getValue(),
+                max_memory,
+                shm_cache_arg.getValue(),
+                result_cache_arg.getValue(),
+                cross_association_arg.getValue(),
+                ensemble_arg.getValue(),
+                ensemble_output_arg.getValue(),
+                bits_arg.getValue(),
+                components,
+                progress_arg.getValue(),
+                metrics_file_arg.getValue(),
+                timings_arg.getValue(),
+                roofline_arg.getValue(),
+                repeat_arg.getValue(),
+                io_arg.getValue(),
+                match_order_arg.getValue(),
+                permutation_cache_arg.getValue(),
+                write_signature_arg.getValue(),
+                against_signature_arg.getValue(),
+                index_arg.getValue(),
+                evict_page_cache_arg.getValue(),
+                !no_header_check_arg.getValue(),
+                vtk_input_a_arg.getValue(),
+                vtk_input_b_arg.getValue(),
+                data_array_a_arg.getValue(),
+                data_array_b_arg.getValue()};
+}
+
+using ExitHandler = void (*)(int exit_code);
+
+/// Called with the exit code when the program terminates, by main() and by
+/// exitProgram().
+ExitHandler& exitHandler()
+{
+    static ExitHandler handler = nullptr;
+    return handler;
+}
+
+/// Terminates the program for errors which are not returned to main(), e.g.
+/// unreadable input files, after calling the exit handler.
+[[noreturn]] void exitProgram(int const exit_code)
+{
+    if (exitHandler() != nullptr)
+    {
+        exitHandler()(exit_code);
+    }
+    std::exit(exit_code);
+}
+
+template <typename T>
+class ErrorCallback : public vtkCommand
+{
+public:
+    vtkTypeMacro(ErrorCallback, vtkCommand);
+
+    static ErrorCallback<T>* New() { return new ErrorCallback<T>; }
+
+    void Execute(vtkObject* caller, unsigned long vtkNotUsed(eventId),
+                 void* callData) override
+    {
+        // Only the first error is reported, the reader's caller stops after
+        // it.
+        if (failed)
+        {
+            return;
+        }
+        failed = true;
+        auto* reader = static_cast<T*>(caller);
+        std::cerr << "Error reading file `" << reader->GetFileName() << "'\n"
+                  << static_cast<char*>(callData) << "\nAborting." << std::endl;
+    }
+
+    std::atomic<bool> failed{false};
+};
+
+/// Adds the bytes of a file read so far, estimated from the reader's
+/// progress, to the progress counters.
+class ProgressCallback : public vtkCommand
+{
+public:
+    vtkTypeMacro(ProgressCallback, vtkCommand);
+
+    static ProgressCallback* New() { return new ProgressCallback; }
+
+    void Execute(vtkObject* vtkNotUsed(caller),
+                 unsigned long vtkNotUsed(eventId), void* callData) override
+    {
+        auto const fraction = *static_cast<double*>(callData);
+        add(static_cast<std::uint64_t>(fraction * file_size));
+    }
+
+    /// Adds the rest of the file after reading.
+    void finish() { add(file_size); }
+
+    std::uint64_t file_size = 0;
+
+private:
+    void add(std::uint64_t const bytes)
+    {
+        if (bytes > _bytes_reported)
+        {
+            Progress::instance().bytes_read.fetch_add(
+                bytes - _bytes_reported, std::memory_order_relaxed);
+            _bytes_reported = bytes;
+        }
+    }
+
+    std::uint64_t _bytes_reported = 0;
+};
+
+/// How readMesh() reads the input files.
+enum class IoBackend
+{
+    buffered,
+    mmap,
+    pread,
+    direct
+};
+
+IoBackend& ioBackend()
+{
+    static IoBackend backend = IoBackend::buffered;
+    return backend;
+}
+
+/// Read-only stream buffer over a memory region, which must outlive it.
+class MemoryStreamBuffer : public std::streambuf
+{
+public:
+    MemoryStreamBuffer(char const* const data, std::size_t const size)
+    {
+        auto* const begin = const_cast<char*>(data);
+        setg(begin, begin, begin + size);
+    }
+
+protected:
+    pos_type seekoff(off_type const offset,
+                     std::ios_base::seekdir const direction,
+                     std::ios_base::openmode const mode) override
+    {
+        off_type const base =
+            direction == std::ios_base::beg   ? 0
+            : direction == std::ios_base::cur ? gptr() - eback()
+                                              : egptr() - eback();
+        off_type const position = base + offset;
+        if (!(mode & std::ios_base::in) || position < 0 ||
+            position > egptr() - eback())
+        {
+            return pos_type(off_type(-1));
+        }
+        setg(eback(), eback() + position, egptr());
+        return pos_type(position);
+    }
+
+    pos_type seekpos(pos_type const position,
+                     std::ios_base::openmode const mode) override
+    {
+        return seekoff(off_type(position), std::ios_base::beg, mode);
+    }
+};
+
+/// Contents of a whole file, either read into memory or mapped, and a stream
+/// over them from which VTK reads without copying.
+class FileContents
+{
+public:
+    explicit FileContents(std::string contents)
+        : _contents(std::move(contents)),
+          _buffer(_contents.data(), _contents.size()),
+          _stream(&_buffer)
+    {
+    }
+
+    FileContents(void* const mapping, std::size_t const mapping_size)
+        : _mapping(mapping),
+          _mapping_size(mapping_size),
+          _buffer(static_cast<char const*>(mapping), mapping_size),
+          _stream(&_buffer)
+    {
+    }
+
+    FileContents(FileContents const&) = delete;
+    FileContents& operator=(FileContents const&) = delete;
+
+    ~FileContents()
+    {
+#ifndef _WIN32
+        if (_mapping != nullptr)
+            munmap(_mapping, _mapping_size);
+#endif
+    }
+
+    std::istream& stream() { return _stream; }
+
+private:
+    std::string const _contents;
+    void* const _mapping = nullptr;
+    std::size_t const _mapping_size = 0;
+    MemoryStreamBuffer _buffer;
+    std::istream _stream;
+};
+
+#ifndef _WIN32
+/// Reads the file with parallel pread() calls of 4 MiB blocks. With O_DIRECT
+/// the blocks go through aligned buffers and bypass the page cache; if the
+/// file system does not support it, the file is read normally.
+std::optional<std::string> preadFile(std::string const& filename,
+                                     bool const direct)
+{
+    int fd = -1;
+#ifdef O_DIRECT
+    if (direct)
+    {
+        fd = ::open(filename.c_str(), O_RDONLY | O_DIRECT);
+    }
+#endif
+    bool const is_direct = fd >= 0;
+    if (fd < 0)
+    {
+        fd = ::open(filename.c_str(), O_RDONLY);
+    }
+    struct stat file_stat;
+    if (fd < 0 || fstat(fd, &file_stat) != 0)
+    {
+        if (fd >= 0)
+            ::close(fd);
+        return std::nullopt;
+    }
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    std::int64_t const size = file_stat.st_size;
+    std::int64_t const block_size = 4 << 20;
+    std::size_t const alignment = 4096;
+    std::string contents(size, '\0');
+    std::atomic<bool> failed{false};
+    parallelForChunks(
+        size, block_size,
+        [&](std::int64_t, std::int64_t const begin, std::int64_t const end) {
+            void* aligned = nullptr;
+            if (is_direct &&
+                posix_memalign(&aligned, alignment, block_size) != 0)
+            {
+                failed = true;
+                return;
+            }
+            std::unique_ptr<void, decltype(&std::free)> const buffer(
+                aligned, &std::free);
+            for (std::int64_t offset = begin; offset < end;)
+            {
+                // O_DIRECT needs aligned lengths; the last read may be short.
+                auto* const target = is_direct
+                                         ? static_cast<char*>(buffer.get())
+                                         : contents.data() + offset;
+                auto const length =
+                    is_direct ? block_size - (offset - begin) : end - offset;
+                auto const n = ::pread(fd, target, length, offset);
+                if (n <= 0)
+                {
+                    failed = true;
+                    return;
+                }
+                auto const used = std::min<std::int64_t>(n, end - offset);
+                if (is_direct)
+                    std::memcpy(contents.data() + offset, target, used);
+                offset += used;
+            }
+        });
+    ::close(fd);
+    if (failed)
+    {
+        return std::nullopt;
+    }
+    return contents;
+}
+
+/// Maps the file with a sequential access hint.
+std::unique_ptr<FileContents> mmapFile(std::string const& filename)
+{
+    int const fd = ::open(filename.c_str(), O_RDONLY);
+    struct stat file_stat;
+    if (fd < 0 || fstat(fd, &file_stat) != 0)
+    {
+        if (fd >= 0)
+            ::close(fd);
+        return nullptr;
+    }
+    std::size_t const size = file_stat.st_size;
+    if (size == 0)
+    {
+        ::close(fd);
+        return std::make_unique<FileContents>(std::string{});
+    }
+    void* const data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED)
+    {
+        return nullptr;
+    }
+    madvise(data, size, MADV_SEQUENTIAL);
+    return std::make_unique<FileContents>(data, size);
+}
+#endif
+
+/// Reads the whole file with the selected I/O backend other than the
+/// buffered one, where VTK reads the file itself.
+std::unique_ptr<FileContents> readFileContents(std::string const& filename)
+{
+#ifndef _WIN32
+    if (ioBackend() == IoBackend::mmap)
+        return mmapFile(filename);
+    auto contents = preadFile(filename, ioBackend() == IoBackend::direct);
+    if (!contents)
+        return nullptr;
+    return std::make_unique<FileContents>(std::move(*contents));
+#else
+    std::ifstream file(filename, std::ios::binary);
+    std::string contents{std::istreambuf_iterator<char>(file),
+                         std::istreambuf_iterator<char>()};
+    if (!file && !file.eof())
+        return nullptr;
+    return std::make_unique<FileContents>(std::move(contents));
+#endif
+}
+
+/// Names of the data arrays read from the first or the second input file;
+/// none for the mesh check.
+std::vector<std::string> dataArraysToRead(Args const& args,
+                                          bool const first_file)
+{
+    if (args.meshcheck)
+        return {};
+    if (!first_file)
+        return {args.data_array_b};
+    if (args.vtk_input_b.empty())
+        return {args.data_array_a, args.data_array_b};
+    return {args.data_array_a};
+}
+
+/// Whether the current thread was started by readAsync(). Such a thread
+/// neither ends the program when reading fails nor measures the wall time of
+/// its reads; both are left to the thread waiting for it.
+bool& onReadingThread()
+{
+    thread_local bool reading_thread = false;
+    return reading_thread;
+}
+
+/// Set when reading fails on a thread started by readAsync().
+std::atomic<bool>& readFailed()
+{
+    static std::atomic<bool> failed{false};
+    return failed;
+}
+
+/// Reads the mesh and the given point or cell data arrays of the file. The
+/// other data arrays are disabled before reading and never decoded. A read
+/// error ends the program with exit code 2, on a thread started by
+/// readAsync() it is recorded and nullptr is returned.
+vtkSmartPointer<vtkUnstructuredGrid> readMesh(
+    std::string const& filename, std::vector<std::string> const& data_arrays)
+{
+    if (filename.empty())
+    {
+        return nullptr;
+    }
+
+    if (!stringEndsWith(filename, ".vtu"))
+    {
+        std::cerr << "Error: Expected a file with .vtu extension."
+                  << "File '" << filename << "' not read.";
+        return nullptr;
+    }
+
+    vtkSmartPointer<ErrorCallback<vtkXMLUnstructuredGridReader>> errorCallback =
+        vtkSmartPointer<ErrorCallback<vtkXMLUnstructuredGridReader>>::New();
 
     vtkSmartPointer<vtkXMLUnstructuredGridReader> reader =
         vtkSmartPointer<vtkXMLUnstructuredGridReader>::New();
     reader->AddObserver(vtkCommand::ErrorEvent, errorCallback);
+
+    auto& progress = Progress::instance();
+    std::error_code ec;
+    auto const file_size = std::filesystem::file_size(filename, ec);
+    progress.bytes_total += ec ? 0 : file_size;
+    progress.decode.bytes += ec ? 0 : file_size;
+
+    vtkSmartPointer<ProgressCallback> progress_callback;
+    if (progress.enabled)
+    {
+        progress_callback = vtkSmartPointer<ProgressCallback>::New();
+        progress_callback->file_size = ec ? 0 : file_size;
+        reader->AddObserver(vtkCommand::ProgressEvent, progress_callback);
+    }
+
+    auto const read_error = []() -> vtkSmartPointer<vtkUnstructuredGrid> {
+        if (!onReadingThread())
+        {
+            exitProgram(2);
+        }
+        readFailed() = true;
+        return nullptr;
+    };
+
+    // Read by the reader until Update() returns.
+    std::unique_ptr<FileContents> contents;
     reader->SetFileName(filename.c_str());
-    reader->Update();
+    {
+        // The waiting thread times reads on other threads.
+        ScopedTimer const timer(progress.decode, !onReadingThread());
+        if (ioBackend() != IoBackend::buffered)
+        {
+            contents = readFileContents(filename);
+            if (!contents)
+            {
+                std::cerr << "Error: Could not read file `" << filename
+                          << "'.\n";
+                return read_error();
+            }
+            // A given stream takes precedence over the file name, which is
+            // kept for error messages.
+            reader->SetStream(&contents->stream());
+        }
+        reader->UpdateInformation();
+        if (errorCallback->failed)
+        {
+            return read_error();
+        }
+        for (auto* const selection : {reader->GetPointDataArraySelection(),
+                                      reader->GetCellDataArraySelection()})
+        {
+            selection->DisableAllArrays();
+            for (auto const& name : data_arrays)
+                selection->EnableArray(name.c_str());
+        }
+        reader->Update();
+        if (errorCallback->failed)
+        {
+            return read_error();
+        }
+    }
+    if (progress_callback)
+    {
+        progress_callback->finish();
+    }
     return reader->GetOutput();
 }
 
-std::tuple<vtkSmartPointer<vtkUnstructuredGrid>,
-           vtkSmartPointer<vtkUnstructuredGrid>>
-readMeshes(std::string const& file_a_name, std::string const& file_b_name)
+/// Result of a read on another thread. get() waits for it, timed as reading,
+/// and ends the program with exit code 2 if a read on another thread failed.
+template <typename Result>
+class AsyncRead
+{
+public:
+    explicit AsyncRead(std::future<Result> future) : _future(std::move(future))
+    {
+    }
+
+    Result get()
+    {
+        auto result = [this]() {
+            ScopedTimer const timer(Progress::instance().decode);
+            return _future.get();
+        }();
+        if (readFailed())
+        {
+            exitProgram(2);
+        }
+        return result;
+    }
+
+private:
+    std::future<Result> _future;
+};
+
+/// Calls f() on another thread, which reads without measuring the wall time
+/// and without ending the program; see AsyncRead.
+template <typename Function>
+auto readAsync(Function const& f) -> AsyncRead<decltype(f())>
+{
+    return AsyncRead<decltype(f())>(std::async(std::launch::async, [f]() {
+        onReadingThread() = true;
+        return f();
+    }));
+}
+
+std::tuple<vtkSmartPointer<vtkUnstructuredGrid>,
+           vtkSmartPointer<vtkUnstructuredGrid>>
+readMeshes(std::string const& file_a_name, std::string const& file_b_name,
+           std::vector<std::string> const& data_arrays_a,
+           std::vector<std::string> const& data_arrays_b)
+{
+    // Both files are read concurrently, each one is decoded by one thread.
+    auto mesh_b =
+        readAsync([&]() { return readMesh(file_b_name, data_arrays_b); });
+    auto mesh_a = readMesh(file_a_name, data_arrays_a);
+    return {mesh_a, mesh_b.get()};
+}
+
+/// Attributes of a DataArray element in the XML header of a .vtu file. The
+/// payload of the array is not read.
+struct DataArrayHeader
+{
+    std::string section;  // Enclosing element, e.g. Points or PointData.
+    std::string name;
+    std::string type;    // VTK XML type name, e.g. Float64.
+    std::string format;  // ascii, binary, or appended.
+    int number_of_components = 1;
+    vtkIdType number_of_tuples = -1;  // -1 if not known from the header.
+    std::uint64_t offset = 0;         // Offset into the appended data.
+    // File positions of the first byte of an inline payload and of the
+    // closing tag, or -1 for appended arrays.
+    std::int64_t payload_begin = -1;
+    std::int64_t payload_end = -1;
+    // Hash of the raw payload and size of the decoded payload, known from
+    // the catalog of an indexed directory.
+    bool has_raw_hash = false;
+    std::uint64_t raw_hash = 0;
+    bool has_decoded_size = false;
+    std::uint64_t decoded_size = 0;
+    bool has_range = false;
+    double range_min = 0;
+    double range_max = 0;
+};
+
+/// Everything that can be learned about a .vtu file without decoding any
+/// array payload.
+struct VtuHeader
+{
+    std::string byte_order = "LittleEndian";
+    std::string header_type = "UInt32";
+    std::string compressor;
+    std::string appended_encoding;
+    // File position of the first byte after the '_' marker of the appended
+    // data section, or -1 if there is no appended data.
+    std::int64_t appended_data_position = -1;
+    vtkIdType number_of_pieces = 0;
+    vtkIdType number_of_points = 0;
+    vtkIdType number_of_cells = 0;
+    std::vector<DataArrayHeader> arrays;
+};
+
+/// Size in bytes of a VTK XML type name, 0 for strings and unknown types.
+std::size_t xmlTypeSize(std::string const& type)
+{
+    if (type == "Int8" || type == "UInt8")
+        return 1;
+    if (type == "Int16" || type == "UInt16")
+        return 2;
+    if (type == "Int32" || type == "UInt32" || type == "Float32")
+        return 4;
+    if (type == "Int64" || type == "UInt64" || type == "Float64")
+        return 8;
+    return 0;
+}
+
+/// Splits the inside of an XML tag, e.g. `DataArray type="Float64"`, into the
+/// element name and its attributes.
+std::tuple<std::string, std::map<std::string, std::string>> parseXmlTag(
+    std::string const& tag)
+{
+    auto const is_space = [](char c) {
+        return std::isspace(static_cast<unsigned char>(c)) != 0;
+    };
+
+    std::size_t i = 0;
+    while (i < tag.size() && !is_space(tag[i]) && tag[i] != '/')
+        ++i;
+    std::string const element = tag.substr(0, i);
+
+    std::map<std::string, std::string> attributes;
+    while (i < tag.size())
+    {
+        while (i < tag.size() && (is_space(tag[i]) || tag[i] == '/'))
+            ++i;
+        auto const name_begin = i;
+        while (i < tag.size() && tag[i] != '=' && !is_space(tag[i]))
+            ++i;
+        auto const name = tag.substr(name_begin, i - name_begin);
+        while (i < tag.size() && (is_space(tag[i]) || tag[i] == '='))
+            ++i;
+        if (i >= tag.size() || (tag[i] != '"' && tag[i] != '\''))
+            break;
+        auto const quote = tag[i++];
+        auto const value_end = tag.find(quote, i);
+        if (value_end == std::string::npos)
+            break;
+        attributes[name] = tag.substr(i, value_end - i);
+        i = value_end + 1;
+    }
+    return {element, attributes};
+}
+
+/// Scans the XML structure of a .vtu file up to the appended data section.
+/// Inline array payloads are skipped, not decoded.
+std::optional<VtuHeader> readVtuHeader(std::string const& filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (!file)
+    {
+        return std::nullopt;
+    }
+
+    VtuHeader header;
+    std::vector<std::string> elements;  // Stack of open elements.
+    vtkIdType piece_points = 0;
+    vtkIdType piece_cells = 0;
+    bool vtk_file_found = false;
+    bool in_tag = false;
+    bool in_appended_data = false;
+    std::string tag;
+    std::int64_t tag_position = 0;
+    // Index of the DataArray element whose inline payload is being skipped.
+    std::optional<std::size_t> open_array;
+
+    std::vector<char> buffer(1 << 20);
+    std::int64_t position = 0;
+    while (file.read(buffer.data(), buffer.size()) || file.gcount() > 0)
+    {
+        char const* const begin = buffer.data();
+        char const* const end = begin + file.gcount();
+        for (char const* c = begin; c < end; ++c)
+        {
+            if (in_appended_data)
+            {
+                if (*c == '_')
+                {
+                    header.appended_data_position = position + (c - begin) + 1;
+                    return header;
+                }
+                if (!std::isspace(static_cast<unsigned char>(*c)))
+                {
+                    return std::nullopt;
+                }
+                continue;
+            }
+            if (!in_tag)
+            {
+                c = static_cast<char const*>(std::memchr(c, '<', end - c));
+                if (c == nullptr)
+                    break;
+                tag_position = position + (c - begin);
+                in_tag = true;
+                tag.clear();
+                continue;
+            }
+            if (*c != '>')
+            {
+                tag += *c;
+                continue;
+            }
+            in_tag = false;
+
+            if (tag.empty() || tag[0] == '?' || tag[0] == '!')
+                continue;
+            if (tag[0] == '/')
+            {
+                if (!elements.empty())
+                    elements.pop_back();
+                if (open_array && tag.compare(1, 9, "DataArray") == 0)
+                {
+                    header.arrays[*open_array].payload_end = tag_position;
+                    open_array.reset();
+                }
+                continue;
+            }
+
+            auto const [element, attributes] = parseXmlTag(tag);
+            auto const attribute = [&attributes = attributes](
+                                       std::string const& name,
+                                       std::string const& default_value) {
+                auto const it = attributes.find(name);
+                return it == attributes.end() ? default_value : it->second;
+            };
+
+            if (element == "VTKFile")
+            {
+                vtk_file_found = true;
+                header.byte_order = attribute("byte_order", "LittleEndian");
+                header.header_type = attribute("header_type", "UInt32");
+                header.compressor = attribute("compressor", "");
+            }
+            else if (element == "Piece")
+            {
+                auto const points = parseInteger<vtkIdType>(
+                    attribute("NumberOfPoints", "0"));
+                auto const cells = parseInteger<vtkIdType>(
+                    attribute("NumberOfCells", "0"));
+                if (!points || !cells)
+                {
+                    return std::nullopt;
+                }
+                piece_points = *points;
+                piece_cells = *cells;
+                header.number_of_pieces++;
+                header.number_of_points += piece_points;
+                header.number_of_cells += piece_cells;
+            }
+            else if (element == "DataArray")
+            {
+                DataArrayHeader array;
+                array.section = elements.empty() ? "" : elements.back();
+                array.name = attribute("Name", "");
+                array.type = attribute("type", "");
+                array.format = attribute("format", "ascii");
+                auto const components =
+                    parseInteger<int>(attribute("NumberOfComponents", "1"));
+                auto const offset =
+                    parseInteger<std::uint64_t>(attribute("offset", "0"));
+                auto const tuples = attribute("NumberOfTuples", "");
+                auto const n_tuples = parseInteger<vtkIdType>(tuples);
+                if (!components || !offset || (!tuples.empty() && !n_tuples))
+                {
+                    return std::nullopt;
+                }
+                array.number_of_components = *components;
+                array.offset = *offset;
+
+                if (n_tuples)
+                    array.number_of_tuples = *n_tuples;
+                else if (array.section == "Points" ||
+                         array.section == "PointData")
+                    array.number_of_tuples = piece_points;
+                else if (array.section == "CellData" ||
+                         (array.section == "Cells" &&
+                          (array.name == "offsets" || array.name == "types")))
+                    array.number_of_tuples = piece_cells;
+
+                // Unparsable ranges are ignored, they are only used for the
+                // precheck.
+                auto const range_min = parseDouble(attribute("RangeMin", ""));
+                auto const range_max = parseDouble(attribute("RangeMax", ""));
+                if (range_min && range_max)
+                {
+                    array.has_range = true;
+                    array.range_min = *range_min;
+                    array.range_max = *range_max;
+                }
+                if (tag.back() != '/' && array.format != "appended")
+                {
+                    array.payload_begin = position + (c - begin) + 1;
+                    open_array = header.arrays.size();
+                }
+                header.arrays.push_back(array);
+            }
+            else if (element == "AppendedData")
+            {
+                header.appended_encoding = attribute("encoding", "base64");
+                in_appended_data = true;
+                continue;
+            }
+
+            if (tag.back() != '/')
+                elements.push_back(element);
+        }
+        position += file.gcount();
+    }
+
+    if (!vtk_file_found || in_appended_data)
+    {
+        return std::nullopt;
+    }
+    return header;
+}
+
+std::vector<unsigned char> decodeBase64(char const* const data,
+                                        std::size_t const size)
+{
+    auto const value = [](char c) -> int {
+        if (c >= 'A' && c <= 'Z')
+            return c - 'A';
+        if (c >= 'a' && c <= 'z')
+            return c - 'a' + 26;
+        if (c >= '0' && c <= '9')
+            return c - '0' + 52;
+        if (c == '+')
+            return 62;
+        if (c == '/')
+            return 63;
+        return -1;
+    };
+
+    std::vector<unsigned char> result;
+    result.reserve(size / 4 * 3);
+    std::uint32_t bits = 0;
+    int n_bits = 0;
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        auto const v = value(data[i]);
+        if (v < 0)
+            continue;  // Padding and whitespace.
+        bits = (bits << 6) | static_cast<std::uint32_t>(v);
+        n_bits += 6;
+        if (n_bits >= 8)
+        {
+            n_bits -= 8;
+            result.push_back(static_cast<unsigned char>(bits >> n_bits));
+        }
+    }
+    return result;
+}
+
+/// Reads the leading header words of an appended array's payload.
+std::optional<std::vector<std::uint64_t>> readAppendedArrayHeaderWords(
+    std::ifstream& file, VtuHeader const& header, DataArrayHeader const& array,
+    std::size_t const n_words)
+{
+    if (array.format != "appended" || header.appended_data_position < 0)
+    {
+        return std::nullopt;
+    }
+
+    std::size_t const word_size = header.header_type == "UInt64" ? 8 : 4;
+    std::size_t const n_bytes = n_words * word_size;
+    bool const base64 = header.appended_encoding == "base64";
+    std::size_t const n_chars = base64 ? (n_bytes + 2) / 3 * 4 : n_bytes;
+
+    std::vector<char> raw(n_chars);
+    file.clear();
+    file.seekg(header.appended_data_position +
+               static_cast<std::int64_t>(array.offset));
+    if (!file.read(raw.data(), n_chars))
+    {
+        return std::nullopt;
+    }
+
+    std::vector<unsigned char> bytes(raw.begin(), raw.end());
+    if (base64)
+    {
+        bytes = decodeBase64(raw.data(), raw.size());
+    }
+    if (bytes.size() < n_bytes)
+    {
+        return std::nullopt;
+    }
+
+    bool const big_endian = header.byte_order == "BigEndian";
+    std::vector<std::uint64_t> words(n_words);
+    for (std::size_t w = 0; w < n_words; ++w)
+    {
+        for (std::size_t b = 0; b < word_size; ++b)
+        {
+            auto const byte = bytes[w * word_size +
+                                    (big_endian ? word_size - 1 - b : b)];
+            words[w] |= static_cast<std::uint64_t>(byte) << (8 * b);
+        }
+    }
+    return words;
+}
+
+/// Number of decoded payload bytes of an appended array, determined from the
+/// block header at the array's offset.
+std::optional<std::uint64_t> readAppendedArraySize(
+    std::ifstream& file, VtuHeader const& header, DataArrayHeader const& array)
+{
+    if (header.compressor.empty())
+    {
+        auto const words = readAppendedArrayHeaderWords(file, header, array, 1);
+        if (!words)
+            return std::nullopt;
+        return (*words)[0];
+    }
+
+    // Compressed: number of blocks, uncompressed block size, and the
+    // uncompressed size of the last block (0 if it is a full block).
+    auto const words = readAppendedArrayHeaderWords(file, header, array, 3);
+    if (!words)
+        return std::nullopt;
+    auto const n_blocks = (*words)[0];
+    auto const block_size = (*words)[1];
+    auto const last_block_size = (*words)[2];
+    if (n_blocks == 0)
+        return 0;
+    return (n_blocks - 1) * block_size +
+           (last_block_size == 0 ? block_size : last_block_size);
+}
+
+/// File positions [begin, end) of the raw payload of an array. An appended
+/// payload extends to the next array's offset or to the end of the file.
+std::optional<std::pair<std::int64_t, std::int64_t>> payloadExtent(
+    VtuHeader const& header, DataArrayHeader const& array,
+    std::int64_t const file_size)
+{
+    std::int64_t begin = array.payload_begin;
+    std::int64_t end = array.payload_end;
+    if (array.format == "appended")
+    {
+        if (header.appended_data_position < 0)
+            return std::nullopt;
+        auto next = std::numeric_limits<std::uint64_t>::max();
+        for (auto const& other : header.arrays)
+        {
+            if (other.format == "appended" && other.offset > array.offset)
+                next = std::min(next, other.offset);
+        }
+        begin = header.appended_data_position +
+                static_cast<std::int64_t>(array.offset);
+        end = next == std::numeric_limits<std::uint64_t>::max()
+                  ? file_size
+                  : header.appended_data_position +
+                        static_cast<std::int64_t>(next);
+    }
+    if (begin < 0 || end < begin || end > file_size)
+    {
+        return std::nullopt;
+    }
+    return std::make_pair(begin, end);
+}
+
+/// Hashes the bytes [begin, end) of a file in blocks of 4 MiB; the result is
+/// the hash of the sequence of block hashes.
+std::optional<std::uint64_t> hashFileRange(std::ifstream& file,
+                                           std::int64_t const begin,
+                                           std::int64_t const end)
+{
+    constexpr std::int64_t block_size = 4 << 20;
+
+    std::vector<char> buffer(std::min(block_size, end - begin));
+    std::vector<std::uint64_t> hashes;
+    file.clear();
+    file.seekg(begin);
+    for (auto position = begin; position < end; position += block_size)
+    {
+        auto const size = std::min(block_size, end - position);
+        if (!file.read(buffer.data(), size))
+            return std::nullopt;
+        hashes.push_back(hashBytes(buffer.data(), size));
+    }
+    return hashBytes(hashes.data(), hashes.size() * sizeof(hashes[0]));
+}
+
+/// Modification time of a file in the file system clock's ticks, used with
+/// the file size to detect changes.
+std::optional<std::int64_t> modificationTime(std::string const& filename)
+{
+    std::error_code error;
+    auto const time = std::filesystem::last_write_time(filename, error);
+    if (error)
+    {
+        return std::nullopt;
+    }
+    return static_cast<std::int64_t>(time.time_since_epoch().count());
+}
+
+/// Catalog of the headers of the .vtu files in a directory, written by
+/// --index and mapped read-only by comparisons. It is used for a file only
+/// while the file's size and modification time are unchanged. The catalog
+/// consists of a header, the file records sorted by name, the array records,
+/// the compressed sizes of the arrays' blocks and a string pool. Records are
+/// made of 64-bit words in native byte order; strings are offsets and sizes
+/// into the pool.
+class IndexCatalog
+{
+public:
+    static constexpr char const* catalog_name = "vtkdiff.index";
+    static constexpr char magic[8] = {'v', 't', 'k', 'd', 'i', 'd', 'x', 0};
+    static constexpr std::uint64_t version = 1;
+
+    struct String
+    {
+        std::uint64_t offset;
+        std::uint64_t size;
+    };
+
+    struct Header
+    {
+        char magic[8];
+        std::uint64_t version;
+        std::uint64_t n_files;
+        std::uint64_t n_arrays;
+        std::uint64_t n_blocks;
+        std::uint64_t strings_size;
+    };
+
+    struct FileRecord
+    {
+        String name;
+        std::int64_t size;
+        std::int64_t modification_time;
+        String byte_order;
+        String header_type;
+        String compressor;
+        String appended_encoding;
+        std::int64_t appended_data_position;
+        std::int64_t number_of_pieces;
+        std::int64_t number_of_points;
+        std::int64_t number_of_cells;
+        std::uint64_t first_array;
+        std::uint64_t n_arrays;
+    };
+
+    // Bits of ArrayRecord::flags.
+    static constexpr std::uint64_t has_range = 1;
+    static constexpr std::uint64_t has_raw_hash = 2;
+    static constexpr std::uint64_t has_decoded_size = 4;
+
+    struct ArrayRecord
+    {
+        String section;
+        String name;
+        String type;
+        String format;
+        std::int64_t number_of_components;
+        std::int64_t number_of_tuples;
+        std::uint64_t offset;
+        std::int64_t payload_begin;
+        std::int64_t payload_end;
+        std::uint64_t flags;
+        double range_min;
+        double range_max;
+        std::uint64_t raw_hash;
+        std::uint64_t decoded_size;
+        std::uint64_t block_size;  // Uncompressed size of compressed blocks.
+        std::uint64_t first_block;
+        std::uint64_t n_blocks;
+    };
+
+    IndexCatalog(IndexCatalog const&) = delete;
+    IndexCatalog& operator=(IndexCatalog const&) = delete;
+
+    ~IndexCatalog()
+    {
+#ifndef _WIN32
+        munmap(_mapping, _mapping_size);
+#endif
+    }
+
+    /// Header of a .vtu file from the catalog of its directory, if the file
+    /// is indexed and unchanged since. Catalogs are mapped once per run.
+    static std::optional<VtuHeader> lookup(std::string const& filename)
+    {
+        auto const path = std::filesystem::path(filename);
+        auto const catalog_path =
+            (path.parent_path() / catalog_name).string();
+
+        static std::mutex mutex;
+        static std::map<std::string, std::shared_ptr<IndexCatalog const>>
+            catalogs;
+        std::shared_ptr<IndexCatalog const> catalog;
+        {
+            std::lock_guard<std::mutex> const lock(mutex);
+            auto const it = catalogs.find(catalog_path);
+            catalog = it != catalogs.end()
+                          ? it->second
+                          : (catalogs[catalog_path] = map(catalog_path));
+        }
+        if (!catalog)
+        {
+            return std::nullopt;
+        }
+        return catalog->find(path.filename().string(), filename);
+    }
+
+private:
+    IndexCatalog(void* const mapping, std::size_t const mapping_size)
+        : _mapping(mapping), _mapping_size(mapping_size)
+    {
+    }
+
+    static std::shared_ptr<IndexCatalog const> map(std::string const& path)
+    {
+#ifndef _WIN32
+        int const fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            return nullptr;
+        }
+        struct stat file_stat;
+        if (fstat(fd, &file_stat) != 0 ||
+            static_cast<std::size_t>(file_stat.st_size) < sizeof(Header))
+        {
+            ::close(fd);
+            return nullptr;
+        }
+        std::size_t const size = file_stat.st_size;
+        void* const mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED)
+        {
+            return nullptr;
+        }
+
+        std::shared_ptr<IndexCatalog> catalog(
+            new IndexCatalog(mapping, size));
+        auto const& header = catalog->header();
+        if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 ||
+            header.version != version ||
+            size != sizeof(Header) + header.n_files * sizeof(FileRecord) +
+                        header.n_arrays * sizeof(ArrayRecord) +
+                        header.n_blocks * sizeof(std::uint64_t) +
+                        header.strings_size)
+        {
+            return nullptr;
+        }
+        return catalog;
+#else
+        (void)path;
+        return nullptr;
+#endif
+    }
+
+    std::optional<VtuHeader> find(std::string const& name,
+                                  std::string const& filename) const
+    {
+        auto const* const files = this->files();
+        auto const* const files_end = files + header().n_files;
+        auto const file = std::lower_bound(
+            files, files_end, name,
+            [&](FileRecord const& record, std::string const& value) {
+                return string(record.name) < value;
+            });
+        if (file == files_end || string(file->name) != name ||
+            file->first_array + file->n_arrays > header().n_arrays)
+        {
+            return std::nullopt;
+        }
+
+        std::error_code error;
+        auto const size = std::filesystem::file_size(filename, error);
+        auto const modification_time = modificationTime(filename);
+        if (error || static_cast<std::int64_t>(size) != file->size ||
+            modification_time != file->modification_time)
+        {
+            return std::nullopt;
+        }
+
+        VtuHeader header;
+        header.byte_order = string(file->byte_order);
+        header.header_type = string(file->header_type);
+        header.compressor = string(file->compressor);
+        header.appended_encoding = string(file->appended_encoding);
+        header.appended_data_position = file->appended_data_position;
+        header.number_of_pieces = file->number_of_pieces;
+        header.number_of_points = file->number_of_points;
+        header.number_of_cells = file->number_of_cells;
+        auto const* const arrays = this->arrays() + file->first_array;
+        for (std::uint64_t i = 0; i < file->n_arrays; ++i)
+        {
+            auto const& record = arrays[i];
+            DataArrayHeader array;
+            array.section = string(record.section);
+            array.name = string(record.name);
+            array.type = string(record.type);
+            array.format = string(record.format);
+            array.number_of_components = record.number_of_components;
+            array.number_of_tuples = record.number_of_tuples;
+            array.offset = record.offset;
+            array.payload_begin = record.payload_begin;
+            array.payload_end = record.payload_end;
+            array.has_range = (record.flags & has_range) != 0;
+            array.range_min = record.range_min;
+            array.range_max = record.range_max;
+            array.has_raw_hash = (record.flags & has_raw_hash) != 0;
+            array.raw_hash = record.raw_hash;
+            array.has_decoded_size = (record.flags & has_decoded_size) != 0;
+            array.decoded_size = record.decoded_size;
+            header.arrays.push_back(array);
+        }
+        return header;
+    }
+
+    char const* bytes() const { return static_cast<char const*>(_mapping); }
+    Header const& header() const
+    {
+        return *reinterpret_cast<Header const*>(bytes());
+    }
+    FileRecord const* files() const
+    {
+        return reinterpret_cast<FileRecord const*>(bytes() + sizeof(Header));
+    }
+    ArrayRecord const* arrays() const
+    {
+        return reinterpret_cast<ArrayRecord const*>(files() +
+                                                    header().n_files);
+    }
+    char const* strings() const
+    {
+        return reinterpret_cast<char const*>(
+                   arrays() + header().n_arrays) +
+               header().n_blocks * sizeof(std::uint64_t);
+    }
+    std::string string(String const& s) const
+    {
+        if (s.offset + s.size > header().strings_size)
+            return "";
+        return std::string(strings() + s.offset, s.size);
+    }
+
+    void* _mapping;
+    std::size_t _mapping_size;
+};
+
+/// Header of a .vtu file, from the catalog of its directory if it is up to
+/// date and scanned otherwise.
+std::optional<VtuHeader> vtuHeader(std::string const& filename)
+{
+    if (auto header = IndexCatalog::lookup(filename))
+    {
+        return header;
+    }
+    return readVtuHeader(filename);
+}
+
+/// Hash of the raw, undecoded payloads of the points and cells arrays of a
+/// .vtu file and of the attributes needed to decode them. Equal hashes imply
+/// equal geometry, while equal geometry stored with a different encoding or
+/// compression hashes differently. The payloads' hashes are taken from the
+/// catalog if there is one. Returns nothing if the payloads cannot be
+/// located.
+std::optional<std::uint64_t> rawGeometryHash(std::string const& filename)
+{
+    if (!stringEndsWith(filename, ".vtu"))
+    {
+        return std::nullopt;
+    }
+    auto const header = vtuHeader(filename);
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!header || !file)
+    {
+        return std::nullopt;
+    }
+    std::int64_t const file_size = file.tellg();
+
+    std::stringstream attributes;
+    attributes << header->byte_order << ' ' << header->header_type << ' '
+               << header->compressor << ' ' << header->appended_encoding;
+    std::vector<std::uint64_t> hashes;
+    for (auto const& array : header->arrays)
+    {
+        if (array.section != "Points" && array.section != "Cells")
+            continue;
+
+        auto const extent = payloadExtent(*header, array, file_size);
+        if (!extent)
+            return std::nullopt;
+        auto const [begin, end] = *extent;
+        attributes << ' ' << array.section << ' ' << array.name << ' '
+                   << array.type << ' ' << array.format << ' '
+                   << array.number_of_components << ' '
+                   << array.number_of_tuples << ' ' << end - begin;
+        auto const hash = array.has_raw_hash
+                              ? std::optional<std::uint64_t>{array.raw_hash}
+                              : hashFileRange(file, begin, end);
+        if (!hash)
+            return std::nullopt;
+        hashes.push_back(*hash);
+    }
+    if (hashes.empty())
+    {
+        return std::nullopt;
+    }
+
+    auto const attributes_string = attributes.str();
+    hashes.push_back(
+        hashBytes(attributes_string.data(), attributes_string.size()));
+    return hashBytes(hashes.data(), hashes.size() * sizeof(hashes[0]));
+}
+
+/// Estimates the memory occupied by the mesh read from the file in bytes.
+/// Cell connectivity is stored by VTK with vtkIdType ids, independent of the
+/// file's type.
+std::uint64_t estimateMemoryFootprint(
+    std::string const& filename, VtuHeader const& header,
+    std::vector<std::string> const& data_arrays)
+{
+    std::ifstream file(filename, std::ios::binary);
+
+    std::uint64_t bytes = 0;
+    for (auto const& array : header.arrays)
+    {
+        // Unselected data arrays are not read.
+        if ((array.section == "PointData" || array.section == "CellData") &&
+            std::find(data_arrays.begin(), data_arrays.end(), array.name) ==
+                data_arrays.end())
+        {
+            continue;
+        }
+        auto const type_size = xmlTypeSize(array.type);
+        if (type_size == 0)
+            continue;
+
+        std::uint64_t n_values = 0;
+        if (array.has_decoded_size)
+            n_values = array.decoded_size / type_size;
+        else if (auto const size = readAppendedArraySize(file, header, array))
+            n_values = *size / type_size;
+        else if (array.number_of_tuples >= 0)
+            n_values = static_cast<std::uint64_t>(array.number_of_tuples) *
+                       array.number_of_components;
+
+        bool const is_cell_ids = array.section == "Cells" &&
+                                 array.name != "types";
+        bytes += n_values * (is_cell_ids ? sizeof(vtkIdType) : type_size);
+    }
+    return bytes;
+}
+
+/// Checks the estimated memory footprint of reading both files against the
+/// budget given by --max-memory. The estimate uses the file headers only.
+bool admitMemoryFootprint(Args const& args)
+{
+    bool const trace = args.verbose && !args.quiet;
+
+    std::uint64_t total = 0;
+    for (bool const first_file : {true, false})
+    {
+        auto const& filename =
+            first_file ? args.vtk_input_a : args.vtk_input_b;
+        if (filename.empty() || !stringEndsWith(filename, ".vtu"))
+            continue;
+
+        auto const header = vtuHeader(filename);
+        if (!header)
+        {
+            if (trace)
+                std::cout << "Could not estimate the memory footprint of file `"
+                          << filename << "' from its header.\n";
+            continue;
+        }
+        auto const bytes = estimateMemoryFootprint(
+            filename, *header, dataArraysToRead(args, first_file));
+        if (trace)
+            std::cout << "Estimated memory footprint of file `" << filename
+                      << "' is " << bytes << " bytes.\n";
+        total += bytes;
+    }
+
+    if (total > args.max_memory)
+    {
+        std::cerr << "Error: Estimated memory footprint of " << total
+                  << " bytes exceeds the budget of " << args.max_memory
+                  << " bytes given by --max-memory.\n";
+        return false;
+    }
+    if (trace)
+        std::cout << "Admitted comparison with an estimated memory footprint "
+                     "of "
+                  << total << " bytes within the budget of " << args.max_memory
+                  << " bytes.\n";
+    return true;
+}
+
+DataArrayHeader const* findDataArrayHeader(VtuHeader const& header,
+                                           std::string const& section,
+                                           std::string const& name)
+{
+    auto const it = std::find_if(
+        header.arrays.begin(), header.arrays.end(),
+        [&](DataArrayHeader const& array) {
+            return array.section == section && array.name == name;
+        });
+    return it == header.arrays.end() ? nullptr : &*it;
+}
+
+/// Number of components of the compared data arrays if the catalogs of their
+/// files give equal hashes of their raw payloads and equal attributes for
+/// decoding them, which implies equal values without decoding.
+std::optional<int> identicalIndexedPayloads(Args const& args)
+{
+    auto const& file_b =
+        args.vtk_input_b.empty() ? args.vtk_input_a : args.vtk_input_b;
+    if (!stringEndsWith(args.vtk_input_a, ".vtu") ||
+        !stringEndsWith(file_b, ".vtu") ||
+        (args.vtk_input_b.empty() && args.data_array_a == args.data_array_b))
+    {
+        return std::nullopt;
+    }
+
+    auto const header_a = IndexCatalog::lookup(args.vtk_input_a);
+    auto const header_b = IndexCatalog::lookup(file_b);
+    if (!header_a || !header_b || header_a->number_of_pieces != 1 ||
+        header_b->number_of_pieces != 1)
+    {
+        return std::nullopt;
+    }
+
+    // Same association lookup as in readDataArraysFromMeshes().
+    std::string section = "PointData";
+    auto const* a = findDataArrayHeader(*header_a, section, args.data_array_a);
+    if (a == nullptr)
+    {
+        section = "CellData";
+        a = findDataArrayHeader(*header_a, section, args.data_array_a);
+    }
+    auto const* const b =
+        findDataArrayHeader(*header_b, section, args.data_array_b);
+    if (a == nullptr || b == nullptr || !a->has_raw_hash || !b->has_raw_hash)
+    {
+        return std::nullopt;
+    }
+
+    auto const decoding = [](VtuHeader const& header,
+                             DataArrayHeader const& array) {
+        return std::tie(header.byte_order, header.header_type,
+                        header.compressor, header.appended_encoding,
+                        array.type, array.format, array.number_of_components,
+                        array.number_of_tuples);
+    };
+    if (a->raw_hash != b->raw_hash || xmlTypeSize(a->type) == 0 ||
+        decoding(*header_a, *a) != decoding(*header_b, *b))
+    {
+        return std::nullopt;
+    }
+    return a->number_of_components;
+}
+
+/// Lower bounds of the maximum absolute and relative errors between two
+/// arrays derived from their value ranges. For multi-component arrays VTK
+/// stores the range of the tuples' magnitudes, a difference of d in the
+/// magnitudes implies a difference of at least d/sqrt(n) in one component.
+std::tuple<double, double> rangeErrorLowerBounds(DataArrayHeader const& a,
+                                                 DataArrayHeader const& b)
+{
+    // RangeMin and RangeMax are written with limited precision.
+    double const rounding = 1e-6;
+    double const scale = 1 / std::sqrt(a.number_of_components);
+
+    auto const bounds = [&](double const x, double const y,
+                            double const denominator) {
+        double const d =
+            (std::abs(x - y) - rounding * (std::abs(x) + std::abs(y))) * scale;
+        if (!(d > 0))
+            return std::make_tuple(0., 0.);
+        if (denominator == 0)
+            return std::make_tuple(d, std::numeric_limits<double>::infinity());
+        return std::make_tuple(d, d / std::abs(denominator));
+    };
+
+    // The smallest value's tuple of one array is compared to a tuple of the
+    // other array which is at least as large, likewise for the largest.
+    auto const [abs_min, rel_min] = bounds(
+        a.range_min, b.range_min, std::min(a.range_min, b.range_min));
+    auto const [abs_max, rel_max] = bounds(
+        a.range_max, b.range_max, std::max(a.range_max, b.range_max));
+    return {std::max(abs_min, abs_max), std::max(rel_min, rel_max)};
+}
+
+/// Checks the data arrays' types, counts and ranges given in the file
+/// headers, before any payload is decoded. Returns the exit code if the
+/// comparison is known to fail; nothing if the data must be compared.
+std::optional<int> precheckDataArrayHeaders(Args const& args)
+{
+    auto const& file_b =
+        args.vtk_input_b.empty() ? args.vtk_input_a : args.vtk_input_b;
+    if (!stringEndsWith(args.vtk_input_a, ".vtu") ||
+        !stringEndsWith(file_b, ".vtu"))
+    {
+        return std::nullopt;
+    }
+
+    auto const header_a = vtuHeader(args.vtk_input_a);
+    auto const header_b = vtuHeader(file_b);
+    if (!header_a || !header_b || header_a->number_of_pieces != 1 ||
+        header_b->number_of_pieces != 1)
+    {
+        return std::nullopt;
+    }
+
+    // Same association lookup as in readDataArraysFromMeshes().
+    std::string section = "PointData";
+    auto const* a = findDataArrayHeader(*header_a, section, args.data_array_a);
+    if (a == nullptr)
+    {
+        section = "CellData";
+        a = findDataArrayHeader(*header_a, section, args.data_array_a);
+    }
+    auto const* const b =
+        findDataArrayHeader(*header_b, section, args.data_array_b);
+    if (a == nullptr || b == nullptr)
+    {
+        return std::nullopt;
+    }
+
+    if (xmlTypeSize(a->type) == 0)
+    {
+        std::cerr << "Data in data array a is not numeric:\n"
+                  << "data type is " << a->type << "\n";
+        return EXIT_FAILURE;
+    }
+    if (xmlTypeSize(b->type) == 0)
+    {
+        std::cerr << "Data in data array b is not numeric.\n"
+                  << "data type is " << b->type << "\n";
+        return EXIT_FAILURE;
+    }
+
+    if (a->number_of_tuples >= 0 && b->number_of_tuples >= 0 &&
+        a->number_of_tuples != b->number_of_tuples)
+    {
+        std::cerr << "Number of tuples differ:\n"
+                  << a->number_of_tuples << " in data array a and "
+                  << b->number_of_tuples << " in data array b\n";
+        return EXIT_FAILURE;
+    }
+
+    // The component counts and the value ranges, which are ranges of the
+    // tuples' magnitudes, cover all components. Only a selected component
+    // is checked if components are selected.
+    if (!args.components.empty())
+    {
+        auto const selected = args.components.back();
+        auto const n_components =
+            std::min(a->number_of_components, b->number_of_components);
+        if (selected >= n_components)
+        {
+            std::cerr << "Component " << selected
+                      << " was selected, but the data arrays have only "
+                      << n_components << " components.\n";
+            return EXIT_FAILURE;
+        }
+        return std::nullopt;
+    }
+
+    if (a->number_of_components != b->number_of_components)
+    {
+        std::cerr << "Number of components differ:\n"
+                  << a->number_of_components << " in data array a and "
+                  << b->number_of_components << " in data array b\n";
+        return EXIT_FAILURE;
+    }
+
+    if (!a->has_range || !b->has_range)
+    {
+        return std::nullopt;
+    }
+
+    auto const [abs_err, rel_err] = rangeErrorLowerBounds(*a, *b);
+    if (abs_err > args.abs_err_thr && rel_err > args.rel_err_thr)
+    {
+        if (!args.quiet)
+            std::cout << "Value ranges [" << a->range_min << ", "
+                      << a->range_max << "] of data array a and ["
+                      << b->range_min << ", " << b->range_max
+                      << "] of data array b imply an absolute error of at "
+                         "least "
+                      << abs_err << " and a relative error of at least "
+                      << rel_err
+                      << ", larger than the corresponding thresholds "
+                      << args.abs_err_thr << " and " << args.rel_err_thr
+                      << ".\n";
+        return EXIT_FAILURE;
+    }
+    return std::nullopt;
+}
+
+vtkSmartPointer<vtkDataArray> getDataArray(vtkUnstructuredGrid* const mesh,
+                                           std::string const& name,
+                                           bool const point_data)
+{
+    if (point_data)
+    {
+        return vtkSmartPointer<vtkDataArray>{
+            mesh->GetPointData()->GetScalars(name.c_str())};
+    }
+    return vtkSmartPointer<vtkDataArray>{
+        mesh->GetCellData()->GetScalars(name.c_str())};
+}
+
+/// Cells sharing each point, in compressed sparse row layout.
+struct PointCellAdjacency
+{
+    std::vector<vtkIdType> offsets;  // Number of points + 1 entries.
+    std::vector<vtkIdType> cells;
+};
+
+PointCellAdjacency pointCellAdjacency(vtkUnstructuredGrid* const mesh)
+{
+    vtkIdType const n_points = mesh->GetNumberOfPoints();
+    vtkIdType const n_cells = mesh->GetNumberOfCells();
+
+    // The cells are counted and filled in in parallel chunks; sorting each
+    // point's cells afterwards makes the result independent of the threads.
+    std::vector<std::atomic<vtkIdType>> next(n_points);
+    parallelForChunks(n_cells, mesh_chunk_size,
+                      [&](std::int64_t, vtkIdType const begin,
+                          vtkIdType const end) {
+                          auto const ids = vtkSmartPointer<vtkIdList>::New();
+                          for (vtkIdType c = begin; c < end; ++c)
+                          {
+                              mesh->GetCellPoints(c, ids);
+                              for (vtkIdType i = 0; i < ids->GetNumberOfIds();
+                                   ++i)
+                              {
+                                  next[ids->GetId(i)].fetch_add(
+                                      1, std::memory_order_relaxed);
+                              }
+                          }
+                      });
+
+    PointCellAdjacency adjacency;
+    adjacency.offsets.resize(n_points + 1);
+    adjacency.offsets[0] = 0;
+    for (vtkIdType p = 0; p < n_points; ++p)
+    {
+        adjacency.offsets[p + 1] =
+            adjacency.offsets[p] + next[p].load(std::memory_order_relaxed);
+        next[p].store(adjacency.offsets[p], std::memory_order_relaxed);
+    }
+
+    adjacency.cells.resize(adjacency.offsets.back());
+    parallelForChunks(n_cells, mesh_chunk_size,
+                      [&](std::int64_t, vtkIdType const begin,
+                          vtkIdType const end) {
+                          auto const ids = vtkSmartPointer<vtkIdList>::New();
+                          for (vtkIdType c = begin; c < end; ++c)
+                          {
+                              mesh->GetCellPoints(c, ids);
+                              for (vtkIdType i = 0; i < ids->GetNumberOfIds();
+                                   ++i)
+                              {
+                                  adjacency.cells[next[ids->GetId(i)].fetch_add(
+                                      1, std::memory_order_relaxed)] = c;
+                              }
+                          }
+                      });
+    parallelForChunks(n_points, mesh_chunk_size,
+                      [&](std::int64_t, vtkIdType const begin,
+                          vtkIdType const end) {
+                          auto const cells = adjacency.cells.begin();
+                          for (vtkIdType p = begin; p < end; ++p)
+                          {
+                              std::sort(cells + adjacency.offsets[p],
+                                        cells + adjacency.offsets[p + 1]);
+                          }
+                      });
+    return adjacency;
+}
+
+/// Converts a data array to the other association by averaging: a cell's
+/// value is the mean of its points' values, a point's value the mean of the
+/// values of the cells sharing the point.
+vtkSmartPointer<vtkDataArray> convertAssociation(
+    vtkUnstructuredGrid* const mesh, vtkDataArray* const array,
+    bool const to_point_data)
+{
+    auto const n_components = array->GetNumberOfComponents();
+    vtkIdType const n_tuples =
+        to_point_data ? mesh->GetNumberOfPoints() : mesh->GetNumberOfCells();
+
+    auto converted = vtkSmartPointer<vtkDoubleArray>::New();
+    converted->SetName(array->GetName());
+    converted->SetNumberOfComponents(n_components);
+    converted->SetNumberOfTuples(n_tuples);
+    double* const values = converted->GetPointer(0);
+
+    auto const average = [&](vtkIdType const tuple, vtkIdType const* ids,
+                             vtkIdType const n_ids) {
+        for (int component = 0; component < n_components; ++component)
+        {
+            double sum = 0;
+            for (vtkIdType i = 0; i < n_ids; ++i)
+            {
+                sum += array->GetComponent(ids[i], component);
+            }
+            values[tuple * n_components + component] =
+                n_ids == 0 ? 0 : sum / n_ids;
+        }
+    };
+
+    if (to_point_data)
+    {
+        auto const adjacency = pointCellAdjacency(mesh);
+        parallelForChunks(n_tuples, mesh_chunk_size,
+                          [&](std::int64_t, vtkIdType const begin,
+                              vtkIdType const end) {
+                              for (vtkIdType p = begin; p < end; ++p)
+                              {
+                                  auto const offset = adjacency.offsets[p];
+                                  average(p, adjacency.cells.data() + offset,
+                                          adjacency.offsets[p + 1] - offset);
+                              }
+                          });
+    }
+    else
+    {
+        parallelForChunks(n_tuples, mesh_chunk_size,
+                          [&](std::int64_t, vtkIdType const begin,
+                              vtkIdType const end) {
+                              auto const ids =
+                                  vtkSmartPointer<vtkIdList>::New();
+                              for (vtkIdType c = begin; c < end; ++c)
+                              {
+                                  mesh->GetCellPoints(c, ids);
+                                  average(c, ids->GetPointer(0),
+                                          ids->GetNumberOfIds());
+                              }
+                          });
+    }
+    return converted;
+}
+
+/// Finds a data array with the other association than requested and
+/// converts it to the requested one.
+vtkSmartPointer<vtkDataArray> getConvertedDataArray(
+    vtkUnstructuredGrid* const mesh, std::string const& name,
+    bool const point_data)
+{
+    auto const array = getDataArray(mesh, name, !point_data);
+    if (!array)
+    {
+        return nullptr;
+    }
+    return convertAssociation(mesh, array, point_data);
+}
+
+std::tuple<bool, vtkSmartPointer<vtkDataArray>, vtkSmartPointer<vtkDataArray>>
+readDataArraysFromMeshes(
+    std::tuple<vtkSmartPointer<vtkUnstructuredGrid>,
+               vtkSmartPointer<vtkUnstructuredGrid>> const& meshes,
+    std::string const& data_array_a_name,
+    std::string const& data_array_b_name,
+    bool const cross_association)
+{
+    if (std::get<0>(meshes) == nullptr)
+    {
+        std::cerr << "First mesh was not read correctly and is a nullptr.\n";
+        return {false, nullptr, nullptr};
+    }
+
+    bool point_data(false);
+    if (std::get<0>(meshes)->GetPointData()->HasArray(
+            data_array_a_name.c_str()))
+    {
+        point_data = true;
+    }
+    else if (std::get<0>(meshes)->GetCellData()->HasArray(
+                 data_array_a_name.c_str()))
+    {
+        point_data = false;
+    }
+    else
+    {
+        std::cerr << "Error: Scalars data array "
+                  << "\'" << data_array_a_name.c_str() << "\'"
+                  << " neither found in point data nor in cell data.\n";
+        return std::make_tuple(false, nullptr, nullptr);
+    }
+
+    // Get arrays
+    vtkSmartPointer<vtkDataArray> a;
+    if (point_data)
+    {
+        a = vtkSmartPointer<vtkDataArray>{
+            std::get<0>(meshes)->GetPointData()->GetScalars(
+                data_array_a_name.c_str())};
+    }
+    else
+    {
+        a = vtkSmartPointer<vtkDataArray>{
+            std::get<0>(meshes)->GetCellData()->GetScalars(
+                data_array_a_name.c_str())};
+    }
+
+    // Check arrays' validity
+    if (!a)
+    {
+        std::cerr << "Error: Scalars data array "
+                  << "\'" << data_array_a_name.c_str() << "\'"
+                  << " could not be read.\n";
+        return std::make_tuple(false, nullptr, nullptr);
+    }
+
+    vtkSmartPointer<vtkDataArray> b;
+    if (std::get<1>(meshes) == nullptr)
+    {
+        if (data_array_a_name == data_array_b_name)
+        {
+            std::cerr << "Error: You are trying to compare data array `"
+                      << data_array_a_name
+                      << "' from first file to itself. Aborting.\n";
+            exitProgram(3);
+        }
+        if (point_data)
+        {
+            b = vtkSmartPointer<vtkDataArray>{
+                std::get<0>(meshes)->GetPointData()->GetScalars(
+                    data_array_b_name.c_str())};
+        }
+        else
+        {
+            b = vtkSmartPointer<vtkDataArray>{
+                std::get<0>(meshes)->GetCellData()->GetScalars(
+                    data_array_b_name.c_str())};
+        }
+    }
+    else
+    {
+        if (point_data)
+        {
+            b = vtkSmartPointer<vtkDataArray>{
+                std::get<1>(meshes)->GetPointData()->GetScalars(
+                    data_array_b_name.c_str())};
+        }
+        else
+        {
+            b = vtkSmartPointer<vtkDataArray>{
+                std::get<1>(meshes)->GetCellData()->GetScalars(
+                    data_array_b_name.c_str())};
+        }
+    }
+
+    if (!b && cross_association)
+    {
+        b = getConvertedDataArray(std::get<1>(meshes) == nullptr
+                                      ? std::get<0>(meshes)
+                                      : std::get<1>(meshes),
+                                  data_array_b_name, point_data);
+    }
+
+    if (!b)
+    {
+        std::cerr << "Error: Scalars data array "
+                  << "\'" << data_array_b_name.c_str() << "\'"
+                  << " not found.\n";
+        return std::make_tuple(false, nullptr, nullptr);
+    }
+
+    return std::make_tuple(true, a, b);
+}
+
+/// Data arrays shared between concurrently running vtkdiff processes through
+/// POSIX shared memory. The first process needing an array claims a segment
+/// named after the file's content hash, the array's association and name,
+/// decodes the array and publishes it there; other processes wait for the
+/// publisher, map the payload read-only and wrap it in a vtkDataArray without
+/// copying. Each process holds a reference on the segments it uses, the last
+/// one to release a segment unlinks it. A process killed while holding a
+/// reference leaves its segments behind in /dev/shm/vtkdiff-*, they are
+/// reused by later runs on the same files and can be removed by hand.
+class SharedArrayCache
+{
+public:
+    struct Entry
+    {
+        vtkSmartPointer<vtkDataArray> array;
+        bool point_data;
+    };
+
+    static SharedArrayCache& instance()
+    {
+        static SharedArrayCache cache;
+        return cache;
+    }
+
+    static std::string segmentName(std::uint64_t const file_hash,
+                                   std::string const& array_name,
+                                   char const association)
+    {
+        return "/vtkdiff-" + toHexString(file_hash) + "-" + association + "-" +
+               toHexString(hashBytes(array_name.data(), array_name.size()));
+    }
+
+#ifndef _WIN32
+    ~SharedArrayCache()
+    {
+        while (!_claims.empty())
+        {
+            abandon(_claims.begin()->first);
+        }
+        for (auto const& segment : _segments)
+        {
+            auto* const header = static_cast<Header*>(segment.header);
+            if (header->users.fetch_sub(1) == 1)
+            {
+                shm_unlink(segment.name.c_str());
+            }
+            if (segment.payload != nullptr)
+            {
+                munmap(segment.payload, segment.payload_size);
+            }
+            munmap(segment.header, pageSize());
+        }
+    }
+
+    /// Maps a published array. Waits for a concurrent publisher to finish.
+    std::optional<Entry> attach(std::string const& name)
+    {
+        int const fd = shm_open(name.c_str(), O_RDWR, 0);
+        if (fd < 0)
+        {
+            return std::nullopt;
+        }
+
+        // The publisher sizes the segment right after creating it.
+        auto const deadline =
+            std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        bool sized = false;
+        struct stat st;
+        while (fstat(fd, &st) == 0)
+        {
+            sized = static_cast<std::size_t>(st.st_size) >= pageSize();
+            if (sized || std::chrono::steady_clock::now() >= deadline)
+            {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if (!sized)
+        {
+            close(fd);
+            return std::nullopt;
+        }
+
+        void* const address = mmap(nullptr, pageSize(), PROT_READ | PROT_WRITE,
+                                   MAP_SHARED, fd, 0);
+        if (address == MAP_FAILED)
+        {
+            close(fd);
+            return std::nullopt;
+        }
+        auto* const header = static_cast<Header*>(address);
+
+        if (!waitUntilReady(name, *header))
+        {
+            munmap(address, pageSize());
+            close(fd);
+            return std::nullopt;
+        }
+        if (header->users.fetch_add(1) == 0)
+        {
+            // The last user is about to unlink the segment.
+            header->users.fetch_sub(1);
+            munmap(address, pageSize());
+            close(fd);
+            return std::nullopt;
+        }
+
+        Segment segment{name, address, nullptr, header->payload_size};
+        if (segment.payload_size > 0)
+        {
+            segment.payload = mmap(nullptr, segment.payload_size, PROT_READ,
+                                   MAP_SHARED, fd, pageSize());
+        }
+        close(fd);
+        if (segment.payload == MAP_FAILED)
+        {
+            segment.payload = nullptr;
+            _segments.push_back(segment);
+            return std::nullopt;
+        }
+        _segments.push_back(segment);
+
+        vtkSmartPointer<vtkDataArray> array;
+        array.TakeReference(vtkDataArray::CreateDataArray(header->data_type));
+        array->SetName(header->array_name);
+        array->SetNumberOfComponents(header->number_of_components);
+        // The payload is never written through, save = 1 keeps VTK from
+        // freeing the mapping.
+        array->SetVoidArray(
+            segment.payload,
+            header->number_of_tuples * header->number_of_components, 1);
+        return Entry{array, header->point_data != 0};
+    }
+
+    /// Maps a published array or, if there is none yet, claims the name by
+    /// creating a placeholder segment which makes other processes wait for
+    /// this one to publish() the array. Returns nothing in the latter case.
+    std::optional<Entry> attachOrClaim(std::string const& name)
+    {
+        // Another process may claim the name between attach() and claim().
+        for (int attempt = 0; attempt < 2; ++attempt)
+        {
+            if (auto entry = attach(name))
+            {
+                return entry;
+            }
+            if (claim(name))
+            {
+                return std::nullopt;
+            }
+        }
+        return std::nullopt;
+    }
+
+    /// Copies a decoded array into the segment claimed by attachOrClaim().
+    /// Does nothing if the name was not claimed by this process.
+    void publish(std::string const& name, vtkDataArray* const array,
+                 bool const point_data)
+    {
+        auto const claim = _claims.find(name);
+        if (claim == _claims.end())
+        {
+            return;
+        }
+        int const fd = claim->second.fd;
+        void* const address = claim->second.header;
+
+        std::string const array_name =
+            array->GetName() == nullptr ? "" : array->GetName();
+        if (!array->HasStandardMemoryLayout() ||
+            array_name.size() >= sizeof(Header::array_name))
+        {
+            abandon(name);
+            return;
+        }
+
+        std::size_t const payload_size =
+            static_cast<std::size_t>(array->GetNumberOfValues()) *
+            array->GetDataTypeSize();
+        if (ftruncate(fd, pageSize() + payload_size) != 0)
+        {
+            abandon(name);
+            return;
+        }
+        void* const payload =
+            payload_size == 0
+                ? nullptr
+                : mmap(nullptr, payload_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED, fd, pageSize());
+        if (payload == MAP_FAILED)
+        {
+            abandon(name);
+            return;
+        }
+        close(fd);
+        _claims.erase(claim);
+
+        auto* const header = static_cast<Header*>(address);
+        header->data_type = array->GetDataType();
+        header->point_data = point_data ? 1 : 0;
+        header->number_of_components = array->GetNumberOfComponents();
+        header->number_of_tuples = array->GetNumberOfTuples();
+        header->payload_size = payload_size;
+        std::strncpy(header->array_name, array_name.c_str(),
+                     sizeof(header->array_name) - 1);
+        if (payload_size > 0)
+        {
+            std::memcpy(payload, array->GetVoidPointer(0), payload_size);
+            munmap(payload, payload_size);
+        }
+        header->state.store(State::ready, std::memory_order_release);
+
+        _segments.push_back(Segment{name, address, nullptr, 0});
+    }
+
+    /// Releases a claimed name without publishing, e.g. because decoding
+    /// failed, and wakes up the processes waiting for it.
+    void abandon(std::string const& name)
+    {
+        auto const claim = _claims.find(name);
+        if (claim == _claims.end())
+        {
+            return;
+        }
+        shm_unlink(name.c_str());
+        auto* const header = static_cast<Header*>(claim->second.header);
+        header->state.store(State::abandoned, std::memory_order_release);
+        munmap(claim->second.header, pageSize());
+        close(claim->second.fd);
+        _claims.erase(claim);
+    }
+#else
+    std::optional<Entry> attachOrClaim(std::string const& /*name*/)
+    {
+        return std::nullopt;
+    }
+    void publish(std::string const& /*name*/, vtkDataArray* const /*array*/,
+                 bool const /*point_data*/)
+    {
+    }
+    void abandon(std::string const& /*name*/) {}
+#endif
+
+private:
+#ifndef _WIN32
+    enum State : std::uint32_t
+    {
+        publishing = 0,
+        ready = 1,
+        abandoned = 2
+    };
+
+    /// Located in the first page of a segment, the payload starts on the
+    /// second page.
+    struct Header
+    {
+        std::atomic<std::uint32_t> state{State::publishing};
+        std::atomic<std::int32_t> users{1};
+        pid_t publisher = 0;
+        int data_type = 0;
+        int point_data = 0;
+        int number_of_components = 0;
+        vtkIdType number_of_tuples = 0;
+        std::size_t payload_size = 0;
+        char array_name[256] = {};
+    };
+    static_assert(std::atomic<std::uint32_t>::is_always_lock_free &&
+                      std::atomic<std::int32_t>::is_always_lock_free,
+                  "Shared memory synchronization requires lock-free atomics.");
+
+    struct Segment
+    {
+        std::string name;
+        void* header;
+        void* payload;
+        std::size_t payload_size;
+    };
+
+    /// Placeholder segment of an array being decoded by this process.
+    struct Claim
+    {
+        int fd;
+        void* header;
+    };
+
+    /// Creates the placeholder segment of an array, fails if the segment
+    /// exists already.
+    bool claim(std::string const& name)
+    {
+        int const fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR,
+                                S_IRUSR | S_IWUSR);
+        if (fd < 0)
+        {
+            return false;
+        }
+        void* const address =
+            ftruncate(fd, pageSize()) != 0
+                ? MAP_FAILED
+                : mmap(nullptr, pageSize(), PROT_READ | PROT_WRITE,
+                       MAP_SHARED, fd, 0);
+        if (address == MAP_FAILED)
+        {
+            close(fd);
+            shm_unlink(name.c_str());
+            return false;
+        }
+        auto* const header = new (address) Header;
+        header->publisher = getpid();
+        _claims[name] = Claim{fd, address};
+        return true;
+    }
+
+    static std::size_t pageSize()
+    {
+        static std::size_t const page_size = sysconf(_SC_PAGESIZE);
+        return page_size;
+    }
+
+    /// Waits for the publisher. A segment left behind by a publisher that
+    /// died is unlinked so that later processes do not wait for it again.
+    static bool waitUntilReady(std::string const& name, Header const& header)
+    {
+        auto const deadline =
+            std::chrono::steady_clock::now() + std::chrono::minutes(2);
+        while (header.state.load(std::memory_order_acquire) != State::ready)
+        {
+            if (header.state.load(std::memory_order_acquire) ==
+                State::abandoned)
+            {
+                return false;
+            }
+            if (kill(header.publisher, 0) != 0 && errno == ESRCH)
+            {
+                shm_unlink(name.c_str());
+                return false;
+            }
+            if (std::chrono::steady_clock::now() > deadline)
+            {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        return true;
+    }
+
+    std::vector<Segment> _segments;
+    std::map<std::string, Claim> _claims;
+#endif
+};
+
+/// Same as readDataArraysFromMeshes() but takes the arrays from the shared
+/// memory cache if possible and reads only the meshes of missing arrays,
+/// which are then published for other processes.
+std::tuple<bool, vtkSmartPointer<vtkDataArray>, vtkSmartPointer<vtkDataArray>>
+readDataArraysWithSharedMemoryCache(Args const& args)
+{
+    auto& cache = SharedArrayCache::instance();
+
+    auto const hash_a = hashFile(args.vtk_input_a);
+    if (!hash_a)
+    {
+        std::cerr << "Error: Could not read file `" << args.vtk_input_a
+                  << "'.\n";
+        return {false, nullptr, nullptr};
+    }
+
+    vtkSmartPointer<vtkUnstructuredGrid> mesh_a;
+    vtkSmartPointer<vtkDataArray> a;
+    bool point_data;
+
+    // Segments are named after the association the array is read with, so
+    // that a file compared as first input in one process and as second input
+    // in another shares them. Point data takes precedence, as in the reader.
+    std::string name_a;
+    if (auto const header = vtuHeader(args.vtk_input_a))
+    {
+        auto const has_array = [&](char const* const section) {
+            return std::any_of(header->arrays.begin(), header->arrays.end(),
+                               [&](DataArrayHeader const& array) {
+                                   return array.section == section &&
+                                          array.name == args.data_array_a;
+                               });
+        };
+        if (has_array("PointData"))
+        {
+            name_a =
+                SharedArrayCache::segmentName(*hash_a, args.data_array_a, 'p');
+        }
+        else if (has_array("CellData"))
+        {
+            name_a =
+                SharedArrayCache::segmentName(*hash_a, args.data_array_a, 'c');
+        }
+    }
+    auto const entry_a =
+        name_a.empty() ? std::nullopt : cache.attachOrClaim(name_a);
+    if (entry_a)
+    {
+        a = entry_a->array;
+        point_data = entry_a->point_data;
+    }
+    else
+    {
+        mesh_a = readMesh(args.vtk_input_a, dataArraysToRead(args, true));
+        if (mesh_a == nullptr)
+        {
+            std::cerr
+                << "First mesh was not read correctly and is a nullptr.\n";
+            cache.abandon(name_a);
+            return {false, nullptr, nullptr};
+        }
+        if (mesh_a->GetPointData()->HasArray(args.data_array_a.c_str()))
+        {
+            point_data = true;
+        }
+        else if (mesh_a->GetCellData()->HasArray(args.data_array_a.c_str()))
+        {
+            point_data = false;
+        }
+        else
+        {
+            std::cerr << "Error: Scalars data array "
+                      << "\'" << args.data_array_a << "\'"
+                      << " neither found in point data nor in cell data.\n";
+            cache.abandon(name_a);
+            return {false, nullptr, nullptr};
+        }
+        a = getDataArray(mesh_a, args.data_array_a, point_data);
+        if (!a)
+        {
+            std::cerr << "Error: Scalars data array "
+                      << "\'" << args.data_array_a << "\'"
+                      << " could not be read.\n";
+            cache.abandon(name_a);
+            return {false, nullptr, nullptr};
+        }
+        cache.publish(name_a, a, point_data);
+    }
+
+    bool const b_from_a = args.vtk_input_b.empty();
+    if (b_from_a && args.data_array_a == args.data_array_b)
+    {
+        std::cerr << "Error: You are trying to compare data array `"
+                  << args.data_array_a
+                  << "' from first file to itself. Aborting.\n";
+        exitProgram(3);
+    }
+
+    auto const hash_b = b_from_a ? hash_a : hashFile(args.vtk_input_b);
+    if (!hash_b)
+    {
+        std::cerr << "Error: Could not read file `" << args.vtk_input_b
+                  << "'.\n";
+        return {false, nullptr, nullptr};
+    }
+
+    vtkSmartPointer<vtkDataArray> b;
+    // Converted arrays are cached under their own names.
+    auto const name_b = SharedArrayCache::segmentName(
+        *hash_b, args.data_array_b,
+        args.cross_association ? (point_data ? 'P' : 'C')
+                               : (point_data ? 'p' : 'c'));
+    if (auto const entry = cache.attachOrClaim(name_b))
+    {
+        b = entry->array;
+    }
+    else
+    {
+        auto const mesh_b =
+            b_from_a
+                ? (mesh_a ? mesh_a
+                          : readMesh(args.vtk_input_a,
+                                     dataArraysToRead(args, true)))
+                : readMesh(args.vtk_input_b, dataArraysToRead(args, false));
+        if (mesh_b != nullptr)
+        {
+            b = getDataArray(mesh_b, args.data_array_b, point_data);
+            if (!b && args.cross_association)
+            {
+                b = getConvertedDataArray(mesh_b, args.data_array_b,
+                                          point_data);
+            }
+        }
+        if (b)
+        {
+            cache.publish(name_b, b, point_data);
+        }
+        else
+        {
+            cache.abandon(name_b);
+        }
+    }
+
+    if (!b)
+    {
+        std::cerr << "Error: Scalars data array "
+                  << "\'" << args.data_array_b << "\'"
+                  << " not found.\n";
+        return {false, nullptr, nullptr};
+    }
+
+    return {true, a, b};
+}
+
+bool compareCellTopology(vtkCellArray* const cells_a,
+                         vtkCellArray* const cells_b)
+{
+    vtkIdType const n_cells_a{cells_a->GetNumberOfCells()};
+    vtkIdType const n_cells_b{cells_b->GetNumberOfCells()};
+
+    if (n_cells_a != n_cells_b)
+    {
+        std::cerr << "Number of cells in the first mesh is " << n_cells_a
+                  << " and differs from the number of cells in the second "
+                     "mesh, which is "
+                  << n_cells_b << "\n";
+        return false;
+    }
+
+    vtkIdType n_cell_points_a, n_cell_points_b;
+    #if (VTK_MAJOR_VERSION > 8 || VTK_MINOR_VERSION == 90)
+        const vtkIdType *cell_points_a, *cell_points_b;
+    #else
+        vtkIdType *cell_points_a, *cell_points_b;
+    #endif
+    cells_a->InitTraversal();
+    cells_b->InitTraversal();
+    int get_next_cell_a = cells_a->GetNextCell(n_cell_points_a, cell_points_a);
+    int get_next_cell_b = cells_b->GetNextCell(n_cell_points_b, cell_points_b);
+    vtkIdType cell_number = 0;
+    while (get_next_cell_a == 1 && get_next_cell_b == 1)
+    {
+        if (n_cell_points_a != n_cell_points_b)
+        {
+            std::cerr << "Cell " << cell_number << " in first input has "
+                      << n_cell_points_a << " points but in the second input "
+                      << n_cell_points_b << " points.\n";
+        }
+
+        for (vtkIdType i = 0; i < n_cell_points_a; ++i)
+        {
+            if (cell_points_a[i] != cell_points_b[i])
+            {
+                std::cerr << "Point " << i << " of cell " << cell_number
+                          << " has id " << cell_points_a[i]
+                          << " in the first input but id " << cell_points_b[i]
+                          << " in the second input.\n";
+                return false;
+            }
+        }
+
+        get_next_cell_a = cells_a->GetNextCell(n_cell_points_a, cell_points_a);
+        get_next_cell_b = cells_b->GetNextCell(n_cell_points_b, cell_points_b);
+        cell_number++;
+    }
+
+    if (get_next_cell_a != 0)
+    {
+        std::cerr << "Unexpected return value (" << get_next_cell_a
+                  << ") for cells_a->GetNextCell() call. Expected 0 for "
+                     "end-of-list or 1 for no error.\n";
+        return false;
+    }
+    if (get_next_cell_b != 0)
+    {
+        std::cerr << "Unexpected return value (" << get_next_cell_b
+                  << ") for cells_b->GetNextCell() call. Expected 0 for "
+                     "end-of-list or 1 for no error.\n";
+        return false;
+    }
+
+    return true;
+}
+
+bool comparePoints(vtkPoints* const points_a, vtkPoints* const points_b,
+                   double const eps_squared)
+{
+    vtkIdType const n_points_a{points_a->GetNumberOfPoints()};
+    vtkIdType const n_points_b{points_b->GetNumberOfPoints()};
+
+    if (n_points_a != n_points_b)
+    {
+        std::cerr << "Number of points in the first mesh is " << n_points_a
+                  << " and differst from the number of point in the second "
+                     "mesh, which is "
+                  << n_points_b << "\n";
+        return false;
+    }
+
+    for (vtkIdType p = 0; p < n_points_a; ++p)
+    {
+        auto const a = points_a->GetPoint(p);
+        auto const b = points_b->GetPoint(p);
+        double const distance2 = vtkMath::Distance2BetweenPoints(a, b);
+        if (distance2 >= eps_squared)
+        {
+            std::cerr << "Point " << p << " with coordinates (" << a[0] << ", "
+                      << a[1] << ", " << a[2]
+                      << ") from the first mesh is significantly different "
+                         "from the same point in the second mesh, which "
+                         "has coordinates ("
+                      << b[0] << ", " << b[1] << ", " << b[2]
+                      << ") with distance between them " << std::sqrt(distance2)
+                      << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Closure of a set of node permutations under composition. A permutation
+/// maps node k to node sigma[k].
+std::vector<std::vector<int>> permutationGroup(
+    std::vector<std::vector<int>> const& generators)
+{
+    std::vector<int> identity(generators.front().size());
+    std::iota(identity.begin(), identity.end(), 0);
+
+    std::vector<std::vector<int>> group{identity};
+    for (std::size_t i = 0; i < group.size(); ++i)
+    {
+        for (auto const& generator : generators)
+        {
+            std::vector<int> product(identity.size());
+            for (std::size_t k = 0; k < product.size(); ++k)
+            {
+                product[k] = generator[group[i][k]];
+            }
+            if (std::find(group.begin(), group.end(), product) == group.end())
+            {
+                group.push_back(product);
+            }
+        }
+    }
+    return group;
+}
+
+/// Extends corner permutations to the mid-edge nodes of a quadratic cell,
+/// which follow the corners in VTK's node ordering.
+std::vector<std::vector<int>> withEdgeNodes(
+    std::vector<std::vector<int>> const& corner_permutations,
+    std::vector<std::pair<int, int>> const& edges)
+{
+    auto const n_corners = static_cast<int>(corner_permutations.front().size());
+    auto const edge_node = [&](int const i, int const j) {
+        for (std::size_t e = 0; e < edges.size(); ++e)
+        {
+            if ((edges[e].first == i && edges[e].second == j) ||
+                (edges[e].first == j && edges[e].second == i))
+            {
+                return n_corners + static_cast<int>(e);
+            }
+        }
+        return -1;
+    };
+
+    std::vector<std::vector<int>> permutations;
+    for (auto permutation : corner_permutations)
+    {
+        for (auto const& [i, j] : edges)
+        {
+            permutation.push_back(edge_node(permutation[i], permutation[j]));
+        }
+        permutations.push_back(permutation);
+    }
+    return permutations;
+}
+
+/// Node permutations of the rotations mapping a reference cell onto itself,
+/// i.e. reorderings of a cell's nodes which keep its shape and orientation.
+/// Cell types without an entry have only the identity.
+std::map<int, std::vector<std::vector<int>>> const& cellRotations()
+{
+    static auto const rotations = []() {
+        auto const triangle = permutationGroup({{1, 2, 0}});
+        auto const quad = permutationGroup({{1, 2, 3, 0}});
+        auto const tetra = permutationGroup({{1, 2, 0, 3}, {0, 2, 3, 1}});
+        auto const hexahedron = permutationGroup(
+            {{1, 2, 3, 0, 5, 6, 7, 4}, {3, 2, 6, 7, 0, 1, 5, 4}});
+        auto const wedge =
+            permutationGroup({{1, 2, 0, 4, 5, 3}, {4, 3, 5, 1, 0, 2}});
+        auto const pyramid = permutationGroup({{1, 2, 3, 0, 4}});
+
+        std::map<int, std::vector<std::vector<int>>> result;
+        result[VTK_TRIANGLE] = triangle;
+        result[VTK_QUAD] = quad;
+        result[VTK_TETRA] = tetra;
+        result[VTK_HEXAHEDRON] = hexahedron;
+        result[VTK_WEDGE] = wedge;
+        result[VTK_PYRAMID] = pyramid;
+        result[VTK_QUADRATIC_TRIANGLE] =
+            withEdgeNodes(triangle, {{0, 1}, {1, 2}, {2, 0}});
+        result[VTK_QUADRATIC_QUAD] =
+            withEdgeNodes(quad, {{0, 1}, {1, 2}, {2, 3}, {3, 0}});
+        result[VTK_QUADRATIC_TETRA] = withEdgeNodes(
+            tetra, {{0, 1}, {1, 2}, {2, 0}, {0, 3}, {1, 3}, {2, 3}});
+        result[VTK_QUADRATIC_HEXAHEDRON] = withEdgeNodes(
+            hexahedron, {{0, 1}, {1, 2}, {2, 3}, {3, 0}, {4, 5}, {5, 6},
+                         {6, 7}, {7, 4}, {0, 4}, {1, 5}, {2, 6}, {3, 7}});
+        result[VTK_QUADRATIC_WEDGE] =
+            withEdgeNodes(wedge, {{0, 1}, {1, 2}, {2, 0}, {3, 4}, {4, 5},
+                                  {5, 3}, {0, 3}, {1, 4}, {2, 5}});
+        result[VTK_QUADRATIC_PYRAMID] =
+            withEdgeNodes(pyramid, {{0, 1}, {1, 2}, {2, 3}, {3, 0}, {0, 4},
+                                    {1, 4}, {2, 4}, {3, 4}});
+        return result;
+    }();
+    return rotations;
+}
+
+/// Brings a cell's node ids, or a polyhedron's face stream, into a canonical
+/// order: the lexicographically smallest of the cell's rotations. Polyhedron
+/// faces are rotated to start at their smallest id and then sorted.
+void canonicalizeNodeOrder(int const cell_type, std::vector<vtkIdType>& ids)
+{
+    if (cell_type == VTK_POLYGON)
+    {
+        std::rotate(ids.begin(), std::min_element(ids.begin(), ids.end()),
+                    ids.end());
+        return;
+    }
+
+    if (cell_type == VTK_POLYHEDRON)
+    {
+        if (ids.empty())
+            return;
+        std::vector<std::vector<vtkIdType>> faces;
+        auto it = ids.begin() + 1;
+        for (vtkIdType f = 0; f < ids.front(); ++f)
+        {
+            if (it == ids.end() || ids.end() - it <= *it)
+                return;  // Malformed stream, compare it as it is.
+            std::vector<vtkIdType> face(it + 1, it + 1 + *it);
+            std::rotate(face.begin(),
+                        std::min_element(face.begin(), face.end()),
+                        face.end());
+            faces.push_back(face);
+            it += 1 + *it;
+        }
+        std::sort(faces.begin(), faces.end());
+
+        it = ids.begin() + 1;
+        for (auto const& face : faces)
+        {
+            *it++ = static_cast<vtkIdType>(face.size());
+            it = std::copy(face.begin(), face.end(), it);
+        }
+        return;
+    }
+
+    auto const rotations = cellRotations().find(cell_type);
+    if (rotations == cellRotations().end() ||
+        rotations->second.front().size() != ids.size())
+    {
+        return;
+    }
+
+    std::vector<vtkIdType> const original = ids;
+    std::vector<vtkIdType> rotated(ids.size());
+    for (auto const& permutation : rotations->second)
+    {
+        for (std::size_t k = 0; k < ids.size(); ++k)
+        {
+            rotated[permutation[k]] = original[k];
+        }
+        if (rotated < ids)
+        {
+            ids = rotated;
+        }
+    }
+}
+
+/// Compares one cell of both meshes by type and by node ids, for polyhedra
+/// by face stream. Returns a description of the difference, empty if the
+/// cells are equal.
+std::string describeCellMismatch(vtkUnstructuredGrid* const mesh_a,
+                                 vtkUnstructuredGrid* const mesh_b,
+                                 vtkIdType const c,
+                                 bool const canonical_node_order,
+                                 vtkIdList* const id_list,
+                                 std::vector<vtkIdType>& ids_a,
+                                 std::vector<vtkIdType>& ids_b)
+{
+    std::stringstream description;
+
+    int const type_a = mesh_a->GetCellType(c);
+    int const type_b = mesh_b->GetCellType(c);
+    if (type_a != type_b)
+    {
+        description << "Cell " << c << " has type " << type_a
+                    << " in the first input but type " << type_b
+                    << " in the second input";
+        return description.str();
+    }
+
+    bool const polyhedron = type_a == VTK_POLYHEDRON;
+    auto const get_ids = [&](vtkUnstructuredGrid* const mesh,
+                             std::vector<vtkIdType>& ids) {
+        if (polyhedron)
+            mesh->GetFaceStream(c, id_list);
+        else
+            mesh->GetCellPoints(c, id_list);
+        ids.assign(id_list->GetPointer(0),
+                   id_list->GetPointer(0) + id_list->GetNumberOfIds());
+        if (canonical_node_order)
+            canonicalizeNodeOrder(type_a, ids);
+    };
+    get_ids(mesh_a, ids_a);
+    get_ids(mesh_b, ids_b);
+
+    char const* const what = polyhedron ? "face stream entries" : "points";
+    if (ids_a.size() != ids_b.size())
+    {
+        description << "Cell " << c << " has " << ids_a.size() << " " << what
+                    << " in the first input but " << ids_b.size() << " "
+                    << what << " in the second input";
+        return description.str();
+    }
+
+    auto const [it_a, it_b] =
+        std::mismatch(ids_a.begin(), ids_a.end(), ids_b.begin());
+    if (it_a == ids_a.end())
+    {
+        return "";
+    }
+    description << (polyhedron ? "Face stream entry " : "Point ")
+                << (it_a - ids_a.begin()) << " of cell " << c << " is "
+                << *it_a << " in the first input but " << *it_b
+                << " in the second input";
+    if (canonical_node_order)
+        description << " (canonical node order)";
+    return description.str();
+}
+
+/// Summary of a full mesh comparison, keeping only the first mismatches.
+struct MismatchReport
+{
+    vtkIdType count = 0;
+    std::vector<std::string> first;  // Descriptions, ordered by id.
+    double max_distance = 0;
+
+    /// Appends a report of the following ids.
+    void merge(MismatchReport const& other, std::size_t const limit)
+    {
+        count += other.count;
+        max_distance = std::max(max_distance, other.max_distance);
+        for (auto const& description : other.first)
+        {
+            if (first.size() >= limit)
+                break;
+            first.push_back(description);
+        }
+    }
+};
+
+/// Squared distance tolerances of the mesh check's points.
+struct PointTolerance
+{
+    double eps_squared;
+    // Empty, or one tolerance per point replacing eps_squared.
+    std::vector<double> local_eps_squared;
+
+    double operator()(vtkIdType const p) const
+    {
+        return local_eps_squared.empty() ? eps_squared : local_eps_squared[p];
+    }
+};
+
+/// For each point the shortest distance to another node of a cell sharing
+/// the point, computed in a parallel pass over the cells. Infinite for points
+/// not used by any cell.
+std::vector<double> localEdgeLengths(vtkUnstructuredGrid* const mesh)
+{
+    vtkIdType const n_points = mesh->GetNumberOfPoints();
+    std::vector<std::atomic<double>> min_lengths(n_points);
+    parallelForChunks(n_points, mesh_chunk_size,
+                      [&](std::int64_t, vtkIdType const begin,
+                          vtkIdType const end) {
+                          for (vtkIdType p = begin; p < end; ++p)
+                          {
+                              min_lengths[p].store(
+                                  std::numeric_limits<double>::infinity(),
+                                  std::memory_order_relaxed);
+                          }
+                      });
+
+    auto* const points = mesh->GetPoints();
+    parallelForChunks(
+        mesh->GetNumberOfCells(), mesh_chunk_size,
+        [&](std::int64_t, vtkIdType const begin, vtkIdType const end) {
+            auto const ids = vtkSmartPointer<vtkIdList>::New();
+            std::vector<std::array<double, 3>> coordinates;
+            std::vector<double> lengths;
+            for (vtkIdType c = begin; c < end; ++c)
+            {
+                mesh->GetCellPoints(c, ids);
+                auto const n = ids->GetNumberOfIds();
+                coordinates.resize(n);
+                lengths.assign(n, std::numeric_limits<double>::infinity());
+                for (vtkIdType i = 0; i < n; ++i)
+                {
+                    points->GetPoint(ids->GetId(i), coordinates[i].data());
+                }
+                for (vtkIdType i = 0; i < n; ++i)
+                {
+                    for (vtkIdType j = i + 1; j < n; ++j)
+                    {
+                        double const length =
+                            std::sqrt(vtkMath::Distance2BetweenPoints(
+                                coordinates[i].data(), coordinates[j].data()));
+                        if (length == 0)
+                            continue;  // Degenerate or repeated node.
+                        lengths[i] = std::min(lengths[i], length);
+                        lengths[j] = std::min(lengths[j], length);
+                    }
+                }
+                for (vtkIdType i = 0; i < n; ++i)
+                {
+                    auto& min_length = min_lengths[ids->GetId(i)];
+                    double current = min_length.load(std::memory_order_relaxed);
+                    while (lengths[i] < current &&
+                           !min_length.compare_exchange_weak(
+                               current, lengths[i], std::memory_order_relaxed))
+                    {
+                    }
+                }
+            }
+        });
+
+    return std::vector<double>(min_lengths.begin(), min_lengths.end());
+}
+
+/// Tolerances of the mesh check: the absolute tolerance, or, if larger, the
+/// relative tolerance scaled by the bounding box diagonal of the first mesh
+/// or by the local edge lengths at each point.
+PointTolerance pointTolerance(Args const& args,
+                              vtkUnstructuredGrid* const mesh)
+{
+    PointTolerance tolerance{args.abs_err_thr * args.abs_err_thr, {}};
+    if (args.mesh_rel_thr <= 0)
+    {
+        return tolerance;
+    }
+
+    if (args.mesh_rel_scale == "bbox")
+    {
+        double bounds[6];
+        mesh->GetBounds(bounds);
+        double const diagonal2 = (bounds[1] - bounds[0]) *
+                                     (bounds[1] - bounds[0]) +
+                                 (bounds[3] - bounds[2]) *
+                                     (bounds[3] - bounds[2]) +
+                                 (bounds[5] - bounds[4]) *
+                                     (bounds[5] - bounds[4]);
+        tolerance.eps_squared =
+            std::max(tolerance.eps_squared,
+                     args.mesh_rel_thr * args.mesh_rel_thr * diagonal2);
+        return tolerance;
+    }
+
+    auto lengths = localEdgeLengths(mesh);
+    for (auto& length : lengths)
+    {
+        double const eps = args.mesh_rel_thr * length;
+        length = std::isfinite(eps)
+                     ? std::max(tolerance.eps_squared, eps * eps)
+                     : tolerance.eps_squared;
+    }
+    tolerance.local_eps_squared = std::move(lengths);
+    return tolerance;
+}
+
+template <typename TA, typename TB>
+void squaredDistances(TA const* const a, TB const* const b,
+                      std::int64_t const n, double* const distances2)
+{
+    for (std::int64_t i = 0; i < n; ++i)
+    {
+        double const dx = static_cast<double>(a[3 * i]) - b[3 * i];
+        double const dy = static_cast<double>(a[3 * i + 1]) - b[3 * i + 1];
+        double const dz = static_cast<double>(a[3 * i + 2]) - b[3 * i + 2];
+        distances2[i] = dx * dx + dy * dy + dz * dz;
+    }
+}
+
+/// Squared distances of the points [begin, end) of both point sets. Float
+/// and double coordinates are read directly in a vectorizable loop.
+void squaredPointDistances(vtkPoints* const points_a,
+                           vtkPoints* const points_b, vtkIdType const begin,
+                           vtkIdType const end, double* const distances2)
+{
+    auto* const data_b = points_b->GetData();
+    auto const with_b = [&](auto const* const a) {
+        if (auto* const b = vtkArrayDownCast<vtkDoubleArray>(data_b))
+        {
+            squaredDistances(a, b->GetPointer(3 * begin), end - begin,
+                             distances2);
+            return true;
+        }
+        if (auto* const b = vtkArrayDownCast<vtkFloatArray>(data_b))
+        {
+            squaredDistances(a, b->GetPointer(3 * begin), end - begin,
+                             distances2);
+            return true;
+        }
+        return false;
+    };
+
+    if (auto* const a = vtkArrayDownCast<vtkDoubleArray>(points_a->GetData()))
+    {
+        if (with_b(a->GetPointer(3 * begin)))
+            return;
+    }
+    else if (auto* const a =
+                 vtkArrayDownCast<vtkFloatArray>(points_a->GetData()))
+    {
+        if (with_b(a->GetPointer(3 * begin)))
+            return;
+    }
+
+    for (vtkIdType p = begin; p < end; ++p)
+    {
+        double a[3], b[3];
+        points_a->GetPoint(p, a);
+        points_b->GetPoint(p, b);
+        distances2[p - begin] = vtkMath::Distance2BetweenPoints(a, b);
+    }
+}
+
+bool reportPointMismatches(vtkPoints* const points_a,
+                           vtkPoints* const points_b,
+                           PointTolerance const& tolerance,
+                           std::size_t const limit, bool const summarize)
+{
+    vtkIdType const n_points{points_a->GetNumberOfPoints()};
+    if (n_points != points_b->GetNumberOfPoints())
+    {
+        // Same message as the first-mismatch check.
+        return comparePoints(points_a, points_b, tolerance.eps_squared);
+    }
+
+    std::vector<MismatchReport> chunk_reports(
+        (n_points + mesh_chunk_size - 1) / mesh_chunk_size);
+    parallelForChunks(
+        n_points, mesh_chunk_size,
+        [&](std::int64_t const chunk, vtkIdType const begin,
+            vtkIdType const end) {
+            auto& report = chunk_reports[chunk];
+            std::vector<double> distances2(end - begin);
+            squaredPointDistances(points_a, points_b, begin, end,
+                                  distances2.data());
+
+            double max_distance2 = 0;
+            for (vtkIdType p = begin; p < end; ++p)
+            {
+                double const distance2 = distances2[p - begin];
+                max_distance2 = std::max(max_distance2, distance2);
+                if (distance2 < tolerance(p))
+                    continue;
+
+                report.count++;
+                if (report.first.size() < limit)
+                {
+                    double a[3], b[3];
+                    points_a->GetPoint(p, a);
+                    points_b->GetPoint(p, b);
+                    std::stringstream description;
+                    description << std::scientific
+                                << std::setprecision(
+                                       std::numeric_limits<double>::digits10)
+                                << "Point " << p << " (" << a[0] << ", "
+                                << a[1] << ", " << a[2] << ") / (" << b[0]
+                                << ", " << b[1] << ", " << b[2]
+                                << "), distance " << std::sqrt(distance2)
+                                << ", tolerance " << std::sqrt(tolerance(p));
+                    report.first.push_back(description.str());
+                }
+            }
+            report.max_distance = std::sqrt(max_distance2);
+        });
+
+    MismatchReport report;
+    for (auto const& chunk_report : chunk_reports)
+    {
+        report.merge(chunk_report, limit);
+    }
+
+    if (report.count > 0 || summarize)
+        std::cerr << report.count << " of " << n_points
+                  << " points differ by at least the tolerance, the maximum "
+                     "distance is "
+                  << report.max_distance << ".\n";
+    for (auto const& description : report.first)
+    {
+        std::cerr << "  " << description << "\n";
+    }
+    return report.count == 0;
+}
+
+bool reportCellMismatches(vtkUnstructuredGrid* const mesh_a,
+                          vtkUnstructuredGrid* const mesh_b,
+                          bool const canonical_node_order,
+                          std::size_t const limit, bool const summarize)
+{
+    vtkIdType const n_cells{mesh_a->GetNumberOfCells()};
+    if (n_cells != mesh_b->GetNumberOfCells())
+    {
+        // Same message as the first-mismatch check.
+        return compareCellTopology(mesh_a->GetCells(), mesh_b->GetCells());
+    }
+
+    std::vector<MismatchReport> chunk_reports(
+        (n_cells + mesh_chunk_size - 1) / mesh_chunk_size);
+    parallelForChunks(
+        n_cells, mesh_chunk_size,
+        [&](std::int64_t const chunk, vtkIdType const begin,
+            vtkIdType const end) {
+            auto& report = chunk_reports[chunk];
+            auto const id_list = vtkSmartPointer<vtkIdList>::New();
+            std::vector<vtkIdType> ids_a, ids_b;
+            for (vtkIdType c = begin; c < end; ++c)
+            {
+                auto const description =
+                    describeCellMismatch(mesh_a, mesh_b, c,
+                                         canonical_node_order, id_list, ids_a,
+                                         ids_b);
+                if (description.empty())
+                    continue;
+                report.count++;
+                if (report.first.size() < limit)
+                    report.first.push_back(description);
+            }
+        });
+
+    MismatchReport report;
+    for (auto const& chunk_report : chunk_reports)
+    {
+        report.merge(chunk_report, limit);
+    }
+
+    if (report.count > 0 || summarize)
+        std::cerr << report.count << " of " << n_cells
+                  << " cells differ in their topology.\n";
+    for (auto const& description : report.first)
+    {
+        std::cerr << "  " << description << "\n";
+    }
+    return report.count == 0;
+}
+
+/// Compares the cells in parallel chunks until the first mismatch, which is
+/// reported. Chunks after a found mismatch are skipped.
+bool compareCells(vtkUnstructuredGrid* const mesh_a,
+                  vtkUnstructuredGrid* const mesh_b,
+                  bool const canonical_node_order)
+{
+    vtkIdType const n_cells{mesh_a->GetNumberOfCells()};
+    if (n_cells != mesh_b->GetNumberOfCells())
+    {
+        return compareCellTopology(mesh_a->GetCells(), mesh_b->GetCells());
+    }
+
+    std::atomic<vtkIdType> first_mismatch{n_cells};
+    std::vector<std::string> descriptions(
+        (n_cells + mesh_chunk_size - 1) / mesh_chunk_size);
+    parallelForChunks(
+        n_cells, mesh_chunk_size,
+        [&](std::int64_t const chunk, vtkIdType const begin,
+            vtkIdType const end) {
+            auto const id_list = vtkSmartPointer<vtkIdList>::New();
+            std::vector<vtkIdType> ids_a, ids_b;
+            for (vtkIdType c = begin;
+                 c < end && c < first_mismatch.load(std::memory_order_relaxed);
+                 ++c)
+            {
+                auto description =
+                    describeCellMismatch(mesh_a, mesh_b, c,
+                                         canonical_node_order, id_list, ids_a,
+                                         ids_b);
+                if (description.empty())
+                    continue;
+                descriptions[chunk] = std::move(description);
+                auto first = first_mismatch.load();
+                while (c < first &&
+                       !first_mismatch.compare_exchange_weak(first, c))
+                {
+                }
+                return;
+            }
+        });
+
+    if (first_mismatch == n_cells)
+    {
+        return true;
+    }
+    std::cerr << descriptions[first_mismatch / mesh_chunk_size] << ".\n";
+    return false;
+}
+
+/// Compares the points and cells of two meshes, reporting mismatches as
+/// requested by --mesh-report.
+bool compareMeshes(Args const& args, vtkUnstructuredGrid* const mesh_a,
+                   vtkUnstructuredGrid* const mesh_b)
+{
+    auto const tolerance = pointTolerance(args, mesh_a);
+    if (args.mesh_report > 0 || !tolerance.local_eps_squared.empty())
+    {
+        std::size_t const limit = std::max(1, args.mesh_report);
+        bool const summarize = args.mesh_report > 0 && !args.quiet;
+        bool const points_equal =
+            reportPointMismatches(mesh_a->GetPoints(), mesh_b->GetPoints(),
+                                  tolerance, limit, summarize);
+        bool const cells_equal = reportCellMismatches(
+            mesh_a, mesh_b, args.canonical_node_order, limit, summarize);
+        if (!points_equal || !cells_equal)
+        {
+            std::cerr << "Error in mesh comparison occured.\n";
+            return false;
+        }
+        return true;
+    }
+
+    if (!comparePoints(mesh_a->GetPoints(), mesh_b->GetPoints(),
+                       tolerance.eps_squared))
+    {
+        std::cerr << "Error in mesh points' comparison occured.\n";
+        return false;
+    }
+
+    // Cell types and polyhedron faces are compared, too.
+    if (!compareCells(mesh_a, mesh_b, args.canonical_node_order))
+    {
+        std::cerr << "Error in cells' topology comparison occured.\n";
+        return false;
+    }
+    return true;
+}
+
+/// Hash of the point coordinates, cell types and cell connectivity of a
+/// mesh, computed over chunks in parallel.
+std::uint64_t meshHash(vtkUnstructuredGrid* const mesh)
+{
+    auto* const points = mesh->GetPoints();
+    vtkIdType const n_points = points ? points->GetNumberOfPoints() : 0;
+    vtkIdType const n_cells = mesh->GetNumberOfCells();
+
+    std::vector<std::uint64_t> hashes(
+        2 + (n_points + mesh_chunk_size - 1) / mesh_chunk_size +
+        (n_cells + mesh_chunk_size - 1) / mesh_chunk_size);
+    hashes[0] = n_points;
+    hashes[1] = n_cells;
+    auto* const point_hashes = hashes.data() + 2;
+    auto* const cell_hashes =
+        point_hashes + (n_points + mesh_chunk_size - 1) / mesh_chunk_size;
+
+    parallelForChunks(
+        n_points, mesh_chunk_size,
+        [&](std::int64_t const chunk, vtkIdType const begin,
+            vtkIdType const end) {
+            std::vector<double> coordinates(3 * (end - begin));
+            for (vtkIdType p = begin; p < end; ++p)
+                points->GetPoint(p, &coordinates[3 * (p - begin)]);
+            point_hashes[chunk] =
+                hashBytes(coordinates.data(),
+                          coordinates.size() * sizeof(double));
+        });
+    parallelForChunks(
+        n_cells, mesh_chunk_size,
+        [&](std::int64_t const chunk, vtkIdType const begin,
+            vtkIdType const end) {
+            auto const id_list = vtkSmartPointer<vtkIdList>::New();
+            std::vector<std::int64_t> words;
+            for (vtkIdType c = begin; c < end; ++c)
+            {
+                mesh->GetCellPoints(c, id_list);
+                words.push_back(mesh->GetCellType(c));
+                words.push_back(id_list->GetNumberOfIds());
+                for (vtkIdType i = 0; i < id_list->GetNumberOfIds(); ++i)
+                    words.push_back(id_list->GetId(i));
+            }
+            cell_hashes[chunk] =
+                hashBytes(words.data(), words.size() * sizeof(words[0]));
+        });
+    return hashBytes(hashes.data(), hashes.size() * sizeof(hashes[0]));
+}
+
+/// Maps the points and cells of a mesh to the equal points and cells of a
+/// second mesh with possibly different order. The indices are either owned
+/// or a read-only mapping of a permutation file, which has a 32 byte header
+/// ("vtkdperm", version, number of points, number of cells) followed by the
+/// 64-bit point and cell indices.
+class MeshPermutation
+{
+public:
+    MeshPermutation(std::vector<std::int64_t> indices,
+                    std::int64_t const n_points)
+        : _storage(std::move(indices)),
+          _indices(_storage.data()),
+          _n_points(n_points),
+          _n_cells(_storage.size() - n_points)
+    {
+    }
+
+    MeshPermutation(MeshPermutation const&) = delete;
+    MeshPermutation& operator=(MeshPermutation const&) = delete;
+
+    ~MeshPermutation()
+    {
+#ifndef _WIN32
+        if (_mapping != nullptr)
+            munmap(_mapping, _mapping_size);
+#endif
+    }
+
+    /// Maps a permutation file, checking it against the expected sizes and
+    /// every index against the number of points or cells.
+    static std::shared_ptr<MeshPermutation const> load(
+        std::string const& path, std::int64_t const n_points,
+        std::int64_t const n_cells)
+    {
+#ifndef _WIN32
+        int const fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            return nullptr;
+        }
+        struct stat file_stat;
+        std::size_t const size =
+            header_size + sizeof(std::int64_t) * (n_points + n_cells);
+        if (fstat(fd, &file_stat) != 0 ||
+            static_cast<std::size_t>(file_stat.st_size) != size)
+        {
+            ::close(fd);
+            return nullptr;
+        }
+        void* const mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED)
+        {
+            return nullptr;
+        }
+
+        std::shared_ptr<MeshPermutation> permutation(new MeshPermutation(
+            mapping, size, n_points, n_cells));
+        std::array<std::uint64_t, 4> header;
+        std::memcpy(header.data(), mapping, header_size);
+        if (std::memcmp(mapping, magic, 8) != 0 || header[1] != version ||
+            header[2] != static_cast<std::uint64_t>(n_points) ||
+            header[3] != static_cast<std::uint64_t>(n_cells))
+        {
+            return nullptr;
+        }
+        // The indices are used unchecked, a damaged file must not point
+        // outside of the meshes.
+        auto const in_range = [](std::int64_t const* const begin,
+                                 std::int64_t const n) {
+            return std::all_of(begin, begin + n, [n](std::int64_t const i) {
+                return i >= 0 && i < n;
+            });
+        };
+        if (!in_range(permutation->points(), n_points) ||
+            !in_range(permutation->cells(), n_cells))
+        {
+            return nullptr;
+        }
+        return permutation;
+#else
+        (void)path, (void)n_points, (void)n_cells;
+        return nullptr;
+#endif
+    }
+
+    /// Writes the permutation file atomically.
+    void store(std::string const& path) const
+    {
+        std::error_code error;
+        std::filesystem::create_directories(
+            std::filesystem::path(path).parent_path(), error);
+
+        std::random_device random;
+        auto const temporary_path =
+            path + "." + toHexString(random()) + ".tmp";
+        {
+            std::array<std::uint64_t, 4> header{
+                {0, version, static_cast<std::uint64_t>(_n_points),
+                 static_cast<std::uint64_t>(_n_cells)}};
+            std::memcpy(header.data(), magic, 8);
+            std::ofstream file(temporary_path, std::ios::binary);
+            file.write(reinterpret_cast<char const*>(header.data()),
+                       header_size);
+            file.write(reinterpret_cast<char const*>(_indices),
+                       sizeof(std::int64_t) * (_n_points + _n_cells));
+            if (!file)
+            {
+                file.close();
+                std::filesystem::remove(temporary_path, error);
+                return;
+            }
+        }
+        std::filesystem::rename(temporary_path, path, error);
+        if (error)
+        {
+            std::filesystem::remove(temporary_path, error);
+        }
+    }
+
+    std::int64_t const* points() const { return _indices; }
+    std::int64_t const* cells() const { return _indices + _n_points; }
+
+private:
+    MeshPermutation(void* const mapping, std::size_t const mapping_size,
+                    std::int64_t const n_points, std::int64_t const n_cells)
+        : _indices(reinterpret_cast<std::int64_t const*>(
+              static_cast<char const*>(mapping) + header_size)),
+          _n_points(n_points),
+          _n_cells(n_cells),
+          _mapping(mapping),
+          _mapping_size(mapping_size)
+    {
+    }
+
+    static constexpr char const magic[9] = "vtkdperm";
+    static constexpr std::uint64_t version = 1;
+    static constexpr std::size_t header_size = 32;
+
+    std::vector<std::int64_t> _storage;
+    std::int64_t const* _indices = nullptr;
+    std::int64_t _n_points = 0;
+    std::int64_t _n_cells = 0;
+    void* _mapping = nullptr;
+    std::size_t _mapping_size = 0;
+};
+
+/// Finds for every point of mesh a the nearest point of mesh b within the
+/// point's tolerance of the mesh check, using a spatial hash of mesh b's
+/// points, and for every cell of mesh a the cell of mesh b with the same type
+/// and the same set of matched points. Returns nothing and prints the first
+/// problem if the meshes do not match one-to-one.
+std::shared_ptr<MeshPermutation const> matchMeshes(
+    vtkUnstructuredGrid* const mesh_a, vtkUnstructuredGrid* const mesh_b,
+    PointTolerance const& tolerance)
+{
+    auto* const points_a = mesh_a->GetPoints();
+    auto* const points_b = mesh_b->GetPoints();
+    vtkIdType const n_points = points_a ? points_a->GetNumberOfPoints() : 0;
+    vtkIdType const n_cells = mesh_a->GetNumberOfCells();
+    if (n_points != (points_b ? points_b->GetNumberOfPoints() : 0) ||
+        n_cells != mesh_b->GetNumberOfCells())
+    {
+        std::cerr << "Error: The meshes have different numbers of points or "
+                     "cells and cannot be matched.\n";
+        return nullptr;
+    }
+
+    // Spatial hash with grid cells of size h relative to mesh b's bounds,
+    // about one point per grid cell for evenly spread points. The size does
+    // not depend on the tolerance, which would put all points of meshes with
+    // large coordinates into few grid cells for tiny tolerances; the grid
+    // cells overlapping a point's tolerance are searched instead.
+    double bounds[6] = {0, 0, 0, 0, 0, 0};
+    mesh_b->GetBounds(bounds);
+    double const diagonal =
+        std::sqrt((bounds[1] - bounds[0]) * (bounds[1] - bounds[0]) +
+                  (bounds[3] - bounds[2]) * (bounds[3] - bounds[2]) +
+                  (bounds[5] - bounds[4]) * (bounds[5] - bounds[4]));
+    double const spacing =
+        std::max(std::sqrt(tolerance.eps_squared),
+                 diagonal / std::cbrt(std::max<double>(n_points, 1)));
+    double const h = spacing > 0 ? spacing : 1;
+    // Mesh b's points are in the grid cells 0 to max_index in each dimension,
+    // with one more for rounding.
+    double const max_index = std::floor(diagonal / h) + 1;
+
+    // Points farther than eps from the bounds have no match, also NaNs.
+    auto const within_bounds = [&bounds](double const* const x,
+                                         double const eps) {
+        for (int d = 0; d < 3; ++d)
+        {
+            if (!(x[d] >= bounds[2 * d] - eps &&
+                  x[d] <= bounds[2 * d + 1] + eps))
+                return false;
+        }
+        return true;
+    };
+    auto const grid_coordinate = [&bounds, h](double const x, int const d) {
+        return std::floor((x - bounds[2 * d]) / h);
+    };
+    auto const grid_index = [max_index](double const i) {
+        return static_cast<std::int64_t>(std::clamp(i, 0., max_index));
+    };
+    auto const cell_key = [](std::array<std::int64_t, 3> const& cell) {
+        return hashBytes(cell.data(), sizeof(cell));
+    };
+
+    // Points outside of the bounds get a key no grid cell is likely to have;
+    // they never match anyway.
+    std::vector<std::pair<std::uint64_t, vtkIdType>> keys_b(n_points);
+    parallelForChunks(
+        n_points, mesh_chunk_size,
+        [&](std::int64_t, vtkIdType const begin, vtkIdType const end) {
+            double x[3];
+            for (vtkIdType p = begin; p < end; ++p)
+            {
+                points_b->GetPoint(p, x);
+                if (!within_bounds(x, 0))
+                {
+                    keys_b[p] = {std::numeric_limits<std::uint64_t>::max(), p};
+                    continue;
+                }
+                std::array<std::int64_t, 3> cell;
+                for (int d = 0; d < 3; ++d)
+                {
+                    double const i = grid_coordinate(x[d], d);
+                    assert(i >= 0 && i <= max_index);
+                    cell[d] = grid_index(i);
+                }
+                keys_b[p] = {cell_key(cell), p};
+            }
+        });
+    std::sort(keys_b.begin(), keys_b.end());
+
+    std::vector<std::int64_t> indices(n_points + n_cells, -1);
+    parallelForChunks(
+        n_points, mesh_chunk_size,
+        [&](std::int64_t, vtkIdType const begin, vtkIdType const end) {
+            double a[3], b[3];
+            for (vtkIdType p = begin; p < end; ++p)
+            {
+                points_a->GetPoint(p, a);
+                double nearest = tolerance(p);
+                double const eps = std::sqrt(nearest);
+                if (!within_bounds(a, eps))
+                    continue;
+                // The grid cells overlapping the box of size 2 eps around a.
+                std::array<std::int64_t, 3> first, last;
+                for (int d = 0; d < 3; ++d)
+                {
+                    first[d] = grid_index(grid_coordinate(a[d] - eps, d));
+                    last[d] = grid_index(grid_coordinate(a[d] + eps, d));
+                }
+                for (auto i = first[0]; i <= last[0]; ++i)
+                {
+                    for (auto j = first[1]; j <= last[1]; ++j)
+                    {
+                        for (auto k = first[2]; k <= last[2]; ++k)
+                        {
+                            auto const key = cell_key({{i, j, k}});
+                            for (auto it = std::lower_bound(
+                                     keys_b.begin(), keys_b.end(),
+                                     std::make_pair(key, vtkIdType{0}));
+                                 it != keys_b.end() && it->first == key; ++it)
+                            {
+                                points_b->GetPoint(it->second, b);
+                                double const distance2 =
+                                    vtkMath::Distance2BetweenPoints(a, b);
+                                if (distance2 <= nearest)
+                                {
+                                    nearest = distance2;
+                                    indices[p] = it->second;
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        });
+
+    std::vector<char> used(std::max(n_points, n_cells), 0);
+    for (vtkIdType p = 0; p < n_points; ++p)
+    {
+        if (indices[p] < 0 || used[indices[p]])
+        {
+            std::cerr << "Error: Point " << p << " of the first mesh has "
+                      << (indices[p] < 0 ? "no" : "no unique")
+                      << " matching point in the second mesh.\n";
+            return nullptr;
+        }
+        used[indices[p]] = 1;
+    }
+
+    // Cells are matched by their type and sorted point ids in mesh b.
+    auto const sorted_cell = [](vtkUnstructuredGrid* const mesh,
+                                vtkIdType const c, vtkIdList* const id_list,
+                                std::int64_t const* const point_map,
+                                std::vector<std::int64_t>& ids) {
+        mesh->GetCellPoints(c, id_list);
+        ids.assign(1, mesh->GetCellType(c));
+        for (vtkIdType i = 0; i < id_list->GetNumberOfIds(); ++i)
+        {
+            auto const id = id_list->GetId(i);
+            ids.push_back(point_map ? point_map[id] : id);
+        }
+        std::sort(ids.begin() + 1, ids.end());
+        return hashBytes(ids.data(), ids.size() * sizeof(ids[0]));
+    };
+
+    std::vector<std::pair<std::uint64_t, vtkIdType>> cell_keys_b(n_cells);
+    parallelForChunks(
+        n_cells, mesh_chunk_size,
+        [&](std::int64_t, vtkIdType const begin, vtkIdType const end) {
+            auto const id_list = vtkSmartPointer<vtkIdList>::New();
+            std::vector<std::int64_t> ids;
+            for (vtkIdType c = begin; c < end; ++c)
+                cell_keys_b[c] = {
+                    sorted_cell(mesh_b, c, id_list, nullptr, ids), c};
+        });
+    std::sort(cell_keys_b.begin(), cell_keys_b.end());
+
+    auto* const cell_indices = indices.data() + n_points;
+    parallelForChunks(
+        n_cells, mesh_chunk_size,
+        [&](std::int64_t, vtkIdType const begin, vtkIdType const end) {
+            auto const id_list = vtkSmartPointer<vtkIdList>::New();
+            std::vector<std::int64_t> ids_a, ids_b;
+            for (vtkIdType c = begin; c < end; ++c)
+            {
+                auto const key =
+                    sorted_cell(mesh_a, c, id_list, indices.data(), ids_a);
+                for (auto it = std::lower_bound(
+                         cell_keys_b.begin(), cell_keys_b.end(),
+                         std::make_pair(key, vtkIdType{0}));
+                     it != cell_keys_b.end() && it->first == key; ++it)
+                {
+                    sorted_cell(mesh_b, it->second, id_list, nullptr, ids_b);
+                    if (ids_a == ids_b)
+                    {
+                        cell_indices[c] = it->second;
+                        break;
+                    }
+                }
+            }
+        });
+
+    std::fill(used.begin(), used.end(), 0);
+    for (vtkIdType c = 0; c < n_cells; ++c)
+    {
+        if (cell_indices[c] < 0 || used[cell_indices[c]])
+        {
+            std::cerr << "Error: Cell " << c << " of the first mesh has "
+                      << (cell_indices[c] < 0 ? "no" : "no unique")
+                      << " matching cell in the second mesh.\n";
+            return nullptr;
+        }
+        used[cell_indices[c]] = 1;
+    }
+
+    return std::make_shared<MeshPermutation>(std::move(indices), n_points);
+}
+
+/// Permutations of matched mesh pairs, kept for all comparisons of a run
+/// and, if a directory is given, stored in permutation files there. The key
+/// consists of both meshes' hashes and the options of the matching
+/// tolerance.
+class PermutationCache
+{
+public:
+    static PermutationCache& instance()
+    {
+        static PermutationCache cache;
+        return cache;
+    }
+
+    std::shared_ptr<MeshPermutation const> get(
+        Args const& args, vtkUnstructuredGrid* const mesh_a,
+        vtkUnstructuredGrid* const mesh_b)
+    {
+        std::stringstream tolerance_options;
+        tolerance_options << std::hexfloat << args.abs_err_thr << '\0'
+                          << args.mesh_rel_thr << '\0'
+                          << args.mesh_rel_scale;
+        auto const options = tolerance_options.str();
+        auto const key =
+            toHexString(meshHash(mesh_a)) + "-" +
+            toHexString(meshHash(mesh_b)) + "-" +
+            toHexString(hashBytes(options.data(), options.size()));
+        auto const& directory = args.permutation_cache;
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (auto const it = _permutations.find(key);
+            it != _permutations.end())
+        {
+            return it->second;
+        }
+
+        auto const path = directory + "/" + key + ".perm";
+        std::shared_ptr<MeshPermutation const> permutation;
+        if (!directory.empty())
+        {
+            permutation =
+                MeshPermutation::load(path, mesh_a->GetNumberOfPoints(),
+                                      mesh_a->GetNumberOfCells());
+        }
+        if (!permutation)
+        {
+            permutation =
+                matchMeshes(mesh_a, mesh_b, pointTolerance(args, mesh_a));
+            if (!permutation)
+            {
+                return nullptr;
+            }
+            if (!directory.empty())
+            {
+                permutation->store(path);
+            }
+        }
+        _permutations[key] = permutation;
+        return permutation;
+    }
+
+private:
+    std::mutex _mutex;
+    std::map<std::string, std::shared_ptr<MeshPermutation const>>
+        _permutations;
+};
+
+/// Returns a copy of the array with the tuple indices[i] at position i.
+vtkSmartPointer<vtkDataArray> gatherDataArray(
+    vtkDataArray& array, std::int64_t const* const indices)
+{
+    auto const n_tuples = array.GetNumberOfTuples();
+    vtkSmartPointer<vtkDataArray> result;
+    result.TakeReference(array.NewInstance());
+    result->SetName(array.GetName());
+    result->SetNumberOfComponents(array.GetNumberOfComponents());
+    result->SetNumberOfTuples(n_tuples);
+    parallelForChunks(n_tuples, mesh_chunk_size,
+                      [&](std::int64_t, vtkIdType const begin,
+                          vtkIdType const end) {
+                          for (vtkIdType t = begin; t < end; ++t)
+                              result->SetTuple(t, indices[t], &array);
+                      });
+    return result;
+}
+
+/// Reorders the second mesh's array like the first mesh's points or cells.
+vtkSmartPointer<vtkDataArray> matchDataArray(
+    Args const& args, vtkUnstructuredGrid* const mesh_a,
+    vtkUnstructuredGrid* const mesh_b, vtkDataArray& b, bool const point_data)
+{
+    auto const permutation =
+        PermutationCache::instance().get(args, mesh_a, mesh_b);
+    if (!permutation)
+    {
+        return nullptr;
+    }
+    return gatherDataArray(
+        b, point_data ? permutation->points() : permutation->cells());
+}
+
+/// Checks that both arrays are numeric and have the same numbers of tuples
+/// and components.
+bool checkDataArrayShapes(vtkDataArray& a, vtkDataArray& b)
+{
+    // Check similarity of the data arrays.
+
+    // Is numeric
+    if (!a.IsNumeric())
+    {
+        std::cerr << "Data in data array a is not numeric:\n"
+                  << "data type is " << a.GetDataTypeAsString() << "\n";
+
+        return false;
+    }
+    if (!b.IsNumeric())
+    {
+        std::cerr << "Data in data array b is not numeric.\n"
+                  << "data type is " << b.GetDataTypeAsString() << "\n";
+        return false;
+    }
+
+    auto const num_tuples = a.GetNumberOfTuples();
+    // Number of components
+    if (num_tuples != b.GetNumberOfTuples())
+    {
+        std::cerr << "Number of tuples differ:\n"
+                  << num_tuples << " in data array a and "
+                  << b.GetNumberOfTuples() << " in data array b\n";
+        return false;
+    }
+
+    auto const num_components = a.GetNumberOfComponents();
+    // Number of components
+    if (num_components != b.GetNumberOfComponents())
+    {
+        std::cerr << "Number of components differ:\n"
+                  << num_components << " in data array a and "
+                  << b.GetNumberOfComponents() << " in data array b\n";
+        return false;
+    }
+    return true;
+}
+
+/// Checks that the selected components exist in the array.
+bool checkSelectedComponents(Args const& args, vtkDataArray& a)
+{
+    if (!args.components.empty() &&
+        args.components.back() >= a.GetNumberOfComponents())
+    {
+        std::cerr << "Component " << args.components.back()
+                  << " was selected, but the data arrays have only "
+                  << a.GetNumberOfComponents() << " components.\n";
+        return false;
+    }
+    return true;
+}
+
+/// The selected components, or all components of the array.
+std::vector<int> selectedComponents(Args const& args, vtkDataArray& a)
+{
+    if (!args.components.empty())
+    {
+        return args.components;
+    }
+    std::vector<int> components(a.GetNumberOfComponents());
+    std::iota(components.begin(), components.end(), 0);
+    return components;
+}
+
+/// Componentwise norms of the absolute and relative errors.
+struct ErrorNorms
+{
+    explicit ErrorNorms(int const num_components)
+        : abs_err_norm_l1(num_components),
+          abs_err_norm_2_2(num_components),
+          abs_err_norm_max(num_components),
+          rel_err_norm_l1(num_components),
+          rel_err_norm_2_2(num_components),
+          rel_err_norm_max(num_components)
+    {
+    }
+
+    /// Adds the norms of further tuples.
+    void merge(ErrorNorms const& other)
+    {
+        for (std::size_t c = 0; c < abs_err_norm_l1.size(); ++c)
+        {
+            abs_err_norm_l1[c] += other.abs_err_norm_l1[c];
+            abs_err_norm_2_2[c] += other.abs_err_norm_2_2[c];
+            abs_err_norm_max[c] =
+                std::max(abs_err_norm_max[c], other.abs_err_norm_max[c]);
+            rel_err_norm_l1[c] += other.rel_err_norm_l1[c];
+            rel_err_norm_2_2[c] += other.rel_err_norm_2_2[c];
+            rel_err_norm_max[c] =
+                std::max(rel_err_norm_max[c], other.rel_err_norm_max[c]);
+        }
+    }
+
+    bool exceedThresholds(Args const& args) const
+    {
+        return *std::max_element(abs_err_norm_max.begin(),
+                                 abs_err_norm_max.end()) > args.abs_err_thr &&
+               *std::max_element(rel_err_norm_max.begin(),
+                                 rel_err_norm_max.end()) > args.rel_err_thr;
+    }
+
+    // Absolute error and norms.
+    std::vector<double> abs_err_norm_l1;
+    std::vector<double> abs_err_norm_2_2;
+    std::vector<double> abs_err_norm_max;
+
+    // Relative error and norms.
+    std::vector<double> rel_err_norm_l1;
+    std::vector<double> rel_err_norm_2_2;
+    std::vector<double> rel_err_norm_max;
+};
+
+/// Values of one component of tuples [begin, end) as a pointer and a stride
+/// in elements.
+struct ComponentView
+{
+    std::variant<float const*, double const*> data;
+    std::ptrdiff_t stride;
+};
+
+/// Returns a view of the component c of the tuples [begin, end). Float and
+/// double arrays in array-of-structs and struct-of-arrays layout are read in
+/// place; a constant array is a single value with stride 0. Values of other
+/// arrays are copied into the buffer.
+ComponentView componentView(vtkDataArray& array, int const c,
+                            vtkIdType const begin, vtkIdType const end,
+                            std::vector<double>& buffer)
+{
+    auto const num_components = array.GetNumberOfComponents();
+    if (auto* const aos = vtkArrayDownCast<vtkDoubleArray>(&array))
+    {
+        return {aos->GetPointer(begin * num_components) + c, num_components};
+    }
+    if (auto* const aos = vtkArrayDownCast<vtkFloatArray>(&array))
+    {
+        return {aos->GetPointer(begin * num_components) + c, num_components};
+    }
+    if (array.GetArrayType() == vtkAbstractArray::SoADataArrayTemplate)
+    {
+        if (auto* const soa =
+                vtkArrayDownCast<vtkSOADataArrayTemplate<double>>(&array))
+        {
+            return {soa->GetComponentArrayPointer(c) + begin, 1};
+        }
+        if (auto* const soa =
+                vtkArrayDownCast<vtkSOADataArrayTemplate<float>>(&array))
+        {
+            return {soa->GetComponentArrayPointer(c) + begin, 1};
+        }
+    }
+#if VTK_MAJOR_VERSION > 9 || (VTK_MAJOR_VERSION == 9 && VTK_MINOR_VERSION >= 3)
+    if (vtkArrayDownCast<vtkConstantArray<double>>(&array) != nullptr ||
+        vtkArrayDownCast<vtkConstantArray<float>>(&array) != nullptr)
+    {
+        buffer.assign(1, array.GetComponent(0, c));
+        return {buffer.data(), 0};
+    }
+#endif
+
+    buffer.resize(end - begin);
+    for (vtkIdType t = begin; t < end; ++t)
+    {
+        buffer[t - begin] = array.GetComponent(t, c);
+    }
+    return {buffer.data(), 1};
+}
+
+/// Adds the errors of n values of one component to the norms at index c.
+template <typename TA, typename TB>
+void accumulateErrorNorms(TA const* const a, std::ptrdiff_t const stride_a,
+                          TB const* const b, std::ptrdiff_t const stride_b,
+                          std::int64_t const n, int const c,
+                          ErrorNorms& norms)
+{
+    double abs_l1 = 0, abs_2_2 = 0, abs_max = 0;
+    double rel_l1 = 0, rel_2_2 = 0, rel_max = 0;
+    for (std::int64_t i = 0; i < n; ++i)
+    {
+        double const a_comp = a[i * stride_a];
+        double const b_comp = b[i * stride_b];
+        double const abs_err = std::abs(a_comp - b_comp);
+        abs_l1 += abs_err;
+        abs_2_2 += abs_err * abs_err;
+        abs_max = std::max(abs_max, abs_err);
+
+        double const rel_err =
+            abs_err == 0.0 ? 0.0
+            : (a_comp == 0.0 || b_comp == 0.0)
+                ? std::numeric_limits<double>::infinity()
+                : abs_err / std::min(std::abs(a_comp), std::abs(b_comp));
+        rel_l1 += rel_err;
+        rel_2_2 += rel_err * rel_err;
+        rel_max = std::max(rel_max, rel_err);
+    }
+    norms.abs_err_norm_l1[c] += abs_l1;
+    norms.abs_err_norm_2_2[c] += abs_2_2;
+    norms.abs_err_norm_max[c] = std::max(norms.abs_err_norm_max[c], abs_max);
+    norms.rel_err_norm_l1[c] += rel_l1;
+    norms.rel_err_norm_2_2[c] += rel_2_2;
+    norms.rel_err_norm_max[c] = std::max(norms.rel_err_norm_max[c], rel_max);
+}
+
+/// Prints the values exceeding both thresholds.
+void listThresholdExceedances(vtkDataArray& a, vtkDataArray& b,
+                              Args const& args)
+{
+    auto const digits10 = std::numeric_limits<double>::digits10;
+    auto const num_tuples = a.GetNumberOfTuples();
+    auto const components = selectedComponents(args, a);
+
+    // Columns wide enough for the largest indices.
+    int const tuple_width = std::to_string(num_tuples).size();
+    int const component_width =
+        std::to_string(a.GetNumberOfComponents()).size();
+
+    for (vtkIdType tuple_idx = 0; tuple_idx < num_tuples; ++tuple_idx)
+    {
+        for (auto const component_idx : components)
+        {
+            auto const a_comp = a.GetComponent(tuple_idx, component_idx);
+            auto const b_comp = b.GetComponent(tuple_idx, component_idx);
+            auto const abs_err = std::abs(a_comp - b_comp);
+
+            // relative error:
+            double rel_err;
+
+            if (abs_err == 0.0)
+            {
+                rel_err = 0.0;
+            }
+            else if (a_comp == 0.0 || b_comp == 0.0)
+            {
+                rel_err = std::numeric_limits<double>::infinity();
+            }
+            else
+            {
+                rel_err =
+                    abs_err / std::min(std::abs(a_comp), std::abs(b_comp));
+            }
+
+            if (abs_err > args.abs_err_thr && rel_err > args.rel_err_thr)
+            {
+                std::cout << "tuple: " << std::setw(tuple_width) << tuple_idx
+                          << " component: " << std::setw(component_width)
+                          << component_idx
+                          << ": abs err = " << std::setw(digits10 + 7)
+                          << abs_err
+                          << ", rel err = " << std::setw(digits10 + 7)
+                          << rel_err << "\n";
+            }
+        }
+    }
+}
+
+/// Bytes of both arrays read when comparing the given components.
+std::uint64_t comparedBytes(vtkDataArray& a, vtkDataArray& b,
+                            std::vector<int> const& components)
+{
+    return static_cast<std::uint64_t>(a.GetNumberOfTuples()) *
+           components.size() * (a.GetDataTypeSize() + b.GetDataTypeSize());
+}
+
+/// Norms of the differences of the given components, ordered like them.
+/// Compared tuples are added to the counter per chunk if it is given.
+///
+/// Each component is read through a typed strided view, so float and double
+/// arrays in either memory layout are compared without copies. The tuples
+/// are split into fixed chunks computed in parallel, whose norms are merged
+/// in chunk order; the result does not depend on the number of threads.
+ErrorNorms errorNormsKernel(vtkDataArray& a, vtkDataArray& b,
+                            std::vector<int> const& components,
+                            std::atomic<std::int64_t>* const tuples_compared)
+{
+    auto const num_tuples = a.GetNumberOfTuples();
+    int const num_components = components.size();
+
+    std::vector<ErrorNorms> chunks(
+        (num_tuples + mesh_chunk_size - 1) / mesh_chunk_size,
+        ErrorNorms(num_components));
+    parallelForChunks(
+        num_tuples, mesh_chunk_size,
+        [&](std::int64_t const chunk, vtkIdType const begin,
+            vtkIdType const end) {
+            std::vector<double> buffer_a;
+            std::vector<double> buffer_b;
+            for (int k = 0; k < num_components; ++k)
+            {
+                auto const c = components[k];
+                auto const view_a = componentView(a, c, begin, end, buffer_a);
+                auto const view_b = componentView(b, c, begin, end, buffer_b);
+                std::visit(
+                    [&](auto const* const data_a, auto const* const data_b) {
+                        accumulateErrorNorms(data_a, view_a.stride, data_b,
+                                             view_b.stride, end - begin, k,
+                                             chunks[chunk]);
+                    },
+                    view_a.data, view_b.data);
+            }
+            if (tuples_compared)
+                tuples_compared->fetch_add(end - begin,
+                                           std::memory_order_relaxed);
+        });
+
+    ErrorNorms norms(num_components);
+    for (auto const& chunk : chunks)
+    {
+        norms.merge(chunk);
+    }
+    return norms;
+}
+
+/// Calculates the difference of the data arrays in the selected components.
+/// In verbose mode the values exceeding both thresholds are printed.
+ErrorNorms computeErrorNorms(vtkDataArray& a, vtkDataArray& b,
+                             Args const& args)
+{
+    auto const components = selectedComponents(args, a);
+
+    auto& progress = Progress::instance();
+    progress.tuples_total += a.GetNumberOfTuples();
+    progress.compare.bytes += comparedBytes(a, b, components);
+    ErrorNorms norms(0);
+    {
+        ScopedTimer const timer(progress.compare);
+        norms = errorNormsKernel(a, b, components, &progress.tuples_compared);
+    }
+
+    if (args.verbose)
+    {
+        listThresholdExceedances(a, b, args);
+    }
+    return norms;
+}
+
+/// Measures the read bandwidth of the machine with a STREAM-like sum of two
+/// arrays larger than the caches, and the bandwidth of the compare kernel on
+/// the given arrays, for increasing numbers of threads. Prints the kernel's
+/// bandwidth as a fraction of the measured ceiling. Arrays fitting into the
+/// caches may exceed the ceiling.
+void printRoofline(vtkDataArray& a, vtkDataArray& b,
+                   std::vector<int> const& components)
+{
+    std::int64_t const probe_size = std::int64_t{8} << 20;
+    std::vector<double> x(probe_size);
+    std::vector<double> y(probe_size);
+    std::vector<double> chunk_sums((probe_size + mesh_chunk_size - 1) /
+                                   mesh_chunk_size);
+
+    // Touch the pages in the threads using them later.
+    parallelForChunks(probe_size, mesh_chunk_size,
+                      [&](std::int64_t, std::int64_t const begin,
+                          std::int64_t const end) {
+                          std::fill(x.begin() + begin, x.begin() + end, 1.0);
+                          std::fill(y.begin() + begin, y.begin() + end, 2.0);
+                      });
+
+    // Best of a few runs as in STREAM.
+    auto const best_seconds = [](auto const& run) {
+        double best = std::numeric_limits<double>::infinity();
+        for (int i = 0; i < 3; ++i)
+        {
+            auto const start = std::chrono::steady_clock::now();
+            run();
+            best = std::min(best, std::chrono::duration<double>(
+                                      std::chrono::steady_clock::now() - start)
+                                      .count());
+        }
+        return best;
+    };
+
+    std::vector<unsigned> thread_counts;
+    unsigned const max_threads = numberOfThreads();
+    for (unsigned t = 1; t < max_threads; t *= 2)
+        thread_counts.push_back(t);
+    thread_counts.push_back(max_threads);
+
+    double const probe_bytes = 2. * probe_size * sizeof(double);
+    double const kernel_bytes = comparedBytes(a, b, components);
+    double const gb = 1e9;
+    auto const previous_limit = threadLimit();
+
+    std::cout << "Roofline of the compare kernel:\n";
+    for (auto const threads : thread_counts)
+    {
+        threadLimit() = threads;
+        double const probe_seconds = best_seconds([&]() {
+            parallelForChunks(
+                probe_size, mesh_chunk_size,
+                [&](std::int64_t const chunk, std::int64_t const begin,
+                    std::int64_t const end) {
+                    double sum = 0;
+                    for (auto i = begin; i < end; ++i)
+                        sum += x[i] + y[i];
+                    chunk_sums[chunk] = sum;
+                });
+        });
+        double const kernel_seconds = best_seconds(
+            [&]() { errorNormsKernel(a, b, components, nullptr); });
+
+        double const ceiling = probe_bytes / probe_seconds;
+        double const achieved = kernel_bytes / kernel_seconds;
+        std::cout << "threads " << std::setw(3) << threads
+                  << ": memory bandwidth " << ceiling / gb
+                  << " GB/s, compare kernel " << achieved / gb
+                  << " GB/s, fraction " << achieved / ceiling << "\n";
+    }
+    threadLimit() = previous_limit;
+
+    if (std::accumulate(chunk_sums.begin(), chunk_sums.end(), 0.0) !=
+        3. * probe_size)
+    {
+        std::cerr << "Warning: Bandwidth probe computed a wrong sum.\n";
+    }
+}
+
+void printErrorNorms(
+    ErrorNorms const& norms,
+    std::string const& title = "Computed difference between data arrays:")
+{
+    std::cout << title << "\n";
+    std::cout << "abs l1 norm      = " << norms.abs_err_norm_l1 << "\n";
+    std::cout << "abs l2-norm^2    = " << norms.abs_err_norm_2_2 << "\n";
+
+    // temporary squared norm vector for output.
+    std::vector<double> abs_err_norm_2;
+    std::transform(std::begin(norms.abs_err_norm_2_2),
+                   std::end(norms.abs_err_norm_2_2),
+                   std::back_inserter(abs_err_norm_2),
+                   [](double x) { return std::sqrt(x); });
+    std::cout << "abs l2-norm      = " << abs_err_norm_2 << "\n";
+
+    std::cout << "abs maximum norm = " << norms.abs_err_norm_max << "\n";
+    std::cout << "\n";
+
+    std::cout << "rel l1 norm      = " << norms.rel_err_norm_l1 << "\n";
+    std::cout << "rel l2-norm^2    = " << norms.rel_err_norm_2_2 << "\n";
+
+    // temporary squared norm vector for output.
+    std::vector<double> rel_err_norm_2;
+    std::transform(std::begin(norms.rel_err_norm_2_2),
+                   std::end(norms.rel_err_norm_2_2),
+                   std::back_inserter(rel_err_norm_2),
+                   [](double x) { return std::sqrt(x); });
+    std::cout << "rel l2-norm      = " << norms.rel_err_norm_2_2 << "\n";
+
+    std::cout << "rel maximum norm = " << norms.rel_err_norm_max << "\n";
+}
+
+/// Counts of bit-level differences of one component.
+struct BitDifferences
+{
+    void merge(BitDifferences const& other)
+    {
+        equal += other.equal;
+        sign += other.sign;
+        exponent += other.exponent;
+        for (std::size_t i = 0; i < highest_mantissa_bit.size(); ++i)
+            highest_mantissa_bit[i] += other.highest_mantissa_bit[i];
+    }
+
+    std::int64_t equal = 0;
+    std::int64_t sign = 0;
+    std::int64_t exponent = 0;
+    /// Number of values whose highest differing bit is the given mantissa
+    /// bit, for values with equal sign and exponent.
+    std::vector<std::int64_t> highest_mantissa_bit;
+};
+
+/// Number of bits needed to represent x, 0 for x = 0, like C++20's
+/// std::bit_width(). Branch-free, so that loops calling it can vectorize.
+template <typename U>
+U bitWidth(U x)
+{
+    // Computed in U throughout, mixing in int keeps GCC from vectorizing.
+    U width = 0;
+    for (U shift = 4 * sizeof(U); shift > 0; shift /= 2)
+    {
+        bool const high = (x >> shift) != 0;
+        width += high ? shift : 0;
+        x = high ? x >> shift : x;
+    }
+    return width + (x != 0 ? 1 : 0);
+}
+
+/// Compares the bit patterns of the IEEE-754 values a and b of n tuples in
+/// the given components. T is float or double and U the unsigned integer of
+/// the same size.
+///
+/// The values are classified by the bit width of a XOR b: 0 for equal
+/// values, the full width for a sign mismatch, more than the mantissa bits
+/// for an exponent mismatch, and one more than the highest differing mantissa
+/// bit otherwise. The widths of a block of tuples are computed for all
+/// components in memory order, which GCC vectorizes given AVX2, and then
+/// counted in a histogram per selected component.
+template <typename U, typename T>
+void countBitDifferences(T const* const a, T const* const b,
+                         std::int64_t const n, int const num_components,
+                         std::vector<int> const& components,
+                         std::vector<BitDifferences>& differences)
+{
+    static_assert(sizeof(U) == sizeof(T), "U must have the size of T.");
+    constexpr int mantissa_bits = std::numeric_limits<T>::digits - 1;
+    constexpr int bits = 8 * sizeof(U);
+    constexpr int n_widths = bits + 1;
+    std::size_t const n_selected = components.size();
+
+    // The bit patterns are copied per block; reading T through U is not
+    // allowed, and GCC does not vectorize per-value memcpy() from T. The
+    // widths are kept in U, narrowing them also keeps GCC from vectorizing.
+    std::int64_t const block_tuples = 1024;
+    std::vector<U> bits_a(block_tuples * num_components);
+    std::vector<U> bits_b(block_tuples * num_components);
+    std::vector<U> block(block_tuples * num_components);
+    std::vector<std::int64_t> widths(n_selected * n_widths);
+    for (std::int64_t begin = 0; begin < n; begin += block_tuples)
+    {
+        std::int64_t const n_tuples = std::min(block_tuples, n - begin);
+        std::int64_t const n_values = n_tuples * num_components;
+        std::memcpy(bits_a.data(), a + begin * num_components,
+                    n_values * sizeof(U));
+        std::memcpy(bits_b.data(), b + begin * num_components,
+                    n_values * sizeof(U));
+        for (std::int64_t j = 0; j < n_values; ++j)
+        {
+            block[j] = bitWidth(bits_a[j] ^ bits_b[j]);
+        }
+        for (std::int64_t i = 0; i < n_tuples; ++i)
+        {
+            for (std::size_t k = 0; k < n_selected; ++k)
+            {
+                widths[k * n_widths +
+                       block[i * num_components + components[k]]]++;
+            }
+        }
+    }
+
+    for (std::size_t k = 0; k < n_selected; ++k)
+    {
+        auto const* const w = &widths[k * n_widths];
+        auto& d = differences[k];
+        d.equal += w[0];
+        d.sign += w[bits];
+        d.exponent +=
+            std::accumulate(w + mantissa_bits + 1, w + bits, std::int64_t{0});
+        d.highest_mantissa_bit.resize(mantissa_bits);
+        for (int bit = 0; bit < mantissa_bits; ++bit)
+            d.highest_mantissa_bit[bit] += w[bit + 1];
+    }
+}
+
+/// Bit-level comparison of both arrays per selected component. Float and
+/// double arrays of the same type are compared in their own precision, all
+/// others as doubles.
+std::vector<BitDifferences> computeBitDifferences(
+    vtkDataArray& a, vtkDataArray& b, std::vector<int> const& components)
+{
+    auto const num_tuples = a.GetNumberOfTuples();
+    auto const num_components = a.GetNumberOfComponents();
+
+    std::vector<std::vector<BitDifferences>> chunks(
+        (num_tuples + mesh_chunk_size - 1) / mesh_chunk_size,
+        std::vector<BitDifferences>(components.size()));
+    parallelForChunks(
+        num_tuples, mesh_chunk_size,
+        [&](std::int64_t const chunk, vtkIdType const begin,
+            vtkIdType const end) {
+            auto& differences = chunks[chunk];
+            auto const n = end - begin;
+            auto* const double_a = vtkArrayDownCast<vtkDoubleArray>(&a);
+            auto* const double_b = vtkArrayDownCast<vtkDoubleArray>(&b);
+            if (double_a && double_b)
+            {
+                countBitDifferences<std::uint64_t>(
+                    double_a->GetPointer(begin * num_components),
+                    double_b->GetPointer(begin * num_components), n,
+                    num_components, components, differences);
+                return;
+            }
+            auto* const float_a = vtkArrayDownCast<vtkFloatArray>(&a);
+            auto* const float_b = vtkArrayDownCast<vtkFloatArray>(&b);
+            if (float_a && float_b)
+            {
+                countBitDifferences<std::uint32_t>(
+                    float_a->GetPointer(begin * num_components),
+                    float_b->GetPointer(begin * num_components), n,
+                    num_components, components, differences);
+                return;
+            }
+
+            std::vector<double> values_a(n * num_components);
+            std::vector<double> values_b(n * num_components);
+            for (vtkIdType t = begin; t < end; ++t)
+            {
+                for (auto const c : components)
+                {
+                    values_a[(t - begin) * num_components + c] =
+                        a.GetComponent(t, c);
+                    values_b[(t - begin) * num_components + c] =
+                        b.GetComponent(t, c);
+                }
+            }
+            countBitDifferences<std::uint64_t>(values_a.data(),
+                                               values_b.data(), n,
+                                               num_components, components,
+                                               differences);
+        });
+
+    std::vector<BitDifferences> differences(components.size());
+    for (auto const& chunk : chunks)
+    {
+        for (std::size_t k = 0; k < components.size(); ++k)
+        {
+            differences[k].highest_mantissa_bit.resize(
+                chunk[k].highest_mantissa_bit.size());
+            differences[k].merge(chunk[k]);
+        }
+    }
+    return differences;
+}
+
+void printBitDifferences(std::vector<BitDifferences> const& differences,
+                         std::vector<int> const& components)
+{
+    std::vector<std::int64_t> equal;
+    std::vector<std::int64_t> sign;
+    std::vector<std::int64_t> exponent;
+    for (auto const& d : differences)
+    {
+        equal.push_back(d.equal);
+        sign.push_back(d.sign);
+        exponent.push_back(d.exponent);
+    }
+    std::cout << "Bit-level difference between data arrays:\n";
+    std::cout << "bit-identical values = " << equal << "\n";
+    std::cout << "sign mismatches      = " << sign << "\n";
+    std::cout << "exponent mismatches  = " << exponent << "\n";
+    for (std::size_t k = 0; k < differences.size(); ++k)
+    {
+        auto const& histogram = differences[k].highest_mantissa_bit;
+        if (std::all_of(histogram.begin(), histogram.end(),
+                        [](std::int64_t n) { return n == 0; }))
+        {
+            continue;
+        }
+        std::cout << "highest differing mantissa bit of component "
+                  << components[k] << ":\n";
+        for (std::size_t bit = histogram.size(); bit-- > 0;)
+        {
+            if (histogram[bit] > 0)
+                std::cout << "  bit " << std::setw(2) << bit << ": "
+                          << histogram[bit] << "\n";
+        }
+    }
+}
+
+/// Maximum errors and results of all comparisons of a run, exported by
+/// writeMetricsFile().
+class Metrics
+{
+public:
+    static Metrics& instance()
+    {
+        static Metrics metrics;
+        return metrics;
+    }
+
+    /// Records a comparison of the data array name in the given components.
+    /// The maximum errors are aggregated over all its comparisons.
+    void addComparison(std::string const& name,
+                       std::vector<int> const& components,
+                       ErrorNorms const& norms, bool const failed)
+    {
+        comparisons++;
+        failed_comparisons += failed ? 1 : 0;
+        auto& errors = max_errors[name];
+        for (std::size_t k = 0; k < components.size(); ++k)
+        {
+            auto& [abs_max, rel_max] = errors[components[k]];
+            abs_max = std::max(abs_max, norms.abs_err_norm_max[k]);
+            rel_max = std::max(rel_max, norms.rel_err_norm_max[k]);
+        }
+    }
+
+    /// Writes the comparison results for a result cache entry. The errors
+    /// are stored as bit patterns, so that they are restored exactly.
+    void write(std::ostream& out) const
+    {
+        auto const bits = [](double const value) {
+            std::uint64_t result;
+            std::memcpy(&result, &value, sizeof(value));
+            return result;
+        };
+        out << comparisons << " " << failed_comparisons << " "
+            << max_errors.size() << "\n";
+        for (auto const& [name, errors] : max_errors)
+        {
+            out << name.size() << " " << errors.size() << "\n" << name << "\n";
+            for (auto const& [component, error] : errors)
+            {
+                out << component << " " << bits(std::get<0>(error)) << " "
+                    << bits(std::get<1>(error)) << "\n";
+            }
+        }
+    }
+
+    /// Reads comparison results written by write(). Returns nothing if they
+    /// are incomplete.
+    static std::optional<Metrics> read(std::istream& in)
+    {
+        auto const value = [](std::uint64_t const bits) {
+            double result;
+            std::memcpy(&result, &bits, sizeof(bits));
+            return result;
+        };
+        Metrics metrics;
+        std::size_t n_arrays;
+        if (!(in >> metrics.comparisons >> metrics.failed_comparisons >>
+              n_arrays))
+        {
+            return std::nullopt;
+        }
+        for (std::size_t i = 0; i < n_arrays; ++i)
+        {
+            std::size_t name_size, n_components;
+            if (!(in >> name_size >> n_components) || in.get() != '\n')
+            {
+                return std::nullopt;
+            }
+            std::string name(name_size, '\0');
+            if (!in.read(&name[0], name_size))
+            {
+                return std::nullopt;
+            }
+            auto& errors = metrics.max_errors[name];
+            for (std::size_t k = 0; k < n_components; ++k)
+            {
+                int component;
+                std::uint64_t abs_bits, rel_bits;
+                if (!(in >> component >> abs_bits >> rel_bits))
+                {
+                    return std::nullopt;
+                }
+                errors[component] = {value(abs_bits), value(rel_bits)};
+            }
+        }
+        if (in.get() != '\n')
+        {
+            return std::nullopt;
+        }
+        return metrics;
+    }
+
+    std::int64_t comparisons = 0;
+    std::int64_t failed_comparisons = 0;
+    /// Absolute and relative maximum errors per array and component.
+    std::map<std::string, std::map<int, std::tuple<double, double>>>
+        max_errors;
+    /// Whether the results were taken from the result cache instead.
+    bool result_cache_hit = false;
+};
+
+/// A step of a ParaView data (.pvd) time series.
+struct TimeStep
+{
+    double time;
+    std::string filename;
+};
+
+/// Reads the steps of a .pvd file ordered by time. File names are relative
+/// to the .pvd file's directory. Only the first part of multi-part data sets
+/// is used.
+std::optional<std::vector<TimeStep>> readPvd(std::string const& filename)
+{
+    std::ifstream file(filename);
+    if (!file)
+    {
+        return std::nullopt;
+    }
+    std::string const content{std::istreambuf_iterator<char>(file),
+                              std::istreambuf_iterator<char>()};
+    auto const directory = std::filesystem::path(filename).parent_path();
+
+    std::vector<TimeStep> steps;
+    for (auto begin = content.find('<'); begin != std::string::npos;
+         begin = content.find('<', begin + 1))
+    {
+        auto const end = content.find('>', begin);
+        if (end == std::string::npos)
+            break;
+        auto const [element, attributes] =
+            parseXmlTag(content.substr(begin + 1, end - begin - 1));
+        if (element != "DataSet")
+            continue;
+
+        auto const part = attributes.find("part");
+        if (part != attributes.end() && part->second != "0")
+            continue;
+        auto const time = attributes.find("timestep");
+        auto const step_file = attributes.find("file");
+        if (step_file == attributes.end())
+            return std::nullopt;
+
+        // Steps are sorted by time, which must therefore be finite.
+        auto const step_time = time == attributes.end()
+                                   ? std::optional<double>{0.}
+                                   : parseDouble(time->second);
+        if (!step_time || !std::isfinite(*step_time))
+            return std::nullopt;
+
+        steps.push_back({*step_time, (directory / step_file->second).string()});
+    }
+
+    std::stable_sort(steps.begin(), steps.end(),
+                     [](TimeStep const& x, TimeStep const& y) {
+                         return x.time < y.time;
+                     });
+    return steps;
+}
+
+/// Indices k0 <= k1 of the steps bracketing time t, which are equal if t
+/// matches a step's time up to a relative tolerance. Returns nothing if t is
+/// not covered by the steps.
+std::optional<std::pair<std::size_t, std::size_t>> bracketingSteps(
+    std::vector<TimeStep> const& steps, double const t)
+{
+    double const eps = 1e-12 * std::max(std::abs(steps.front().time),
+                                        std::abs(steps.back().time));
+    if (t < steps.front().time - eps || t > steps.back().time + eps)
+    {
+        return std::nullopt;
+    }
+
+    auto const upper = std::lower_bound(
+        steps.begin(), steps.end(), t - eps,
+        [](TimeStep const& step, double const time) {
+            return step.time < time;
+        });
+    std::size_t const k1 =
+        std::min<std::size_t>(upper - steps.begin(), steps.size() - 1);
+    std::size_t const k0 =
+        std::abs(steps[k1].time - t) <= eps || k1 == 0 ? k1 : k1 - 1;
+    return std::make_pair(k0, k1);
+}
+
+/// Reads a data array from a mesh file. The association is looked up, point
+/// data first, if it is not given; cross_association is applied otherwise.
+/// The mesh is returned through mesh_out if it is given.
+std::tuple<vtkSmartPointer<vtkDataArray>, bool> readStepDataArray(
+    std::string const& filename, std::string const& name,
+    std::optional<bool> const point_data, bool const cross_association,
+    vtkSmartPointer<vtkUnstructuredGrid>* const mesh_out = nullptr)
+{
+    auto const mesh = readMesh(filename, {name});
+    if (mesh_out)
+    {
+        *mesh_out = mesh;
+    }
+    if (mesh == nullptr)
+    {
+        return {nullptr, false};
+    }
+
+    bool const use_point_data =
+        point_data ? *point_data
+                   : mesh->GetPointData()->HasArray(name.c_str()) != 0;
+    auto array = getDataArray(mesh, name, use_point_data);
+    if (!array && point_data && cross_association)
+    {
+        array = getConvertedDataArray(mesh, name, use_point_data);
+    }
+    if (!array)
+    {
+        std::cerr << "Error: Scalars data array "
+                  << "\'" << name << "\'"
+                  << " not found in file `" << filename << "'.\n";
+    }
+    return {array, use_point_data};
+}
+
+/// Linear interpolation (1 - w) * b0 + w * b1 of two arrays of equal shape.
+vtkSmartPointer<vtkDataArray> interpolateDataArrays(vtkDataArray& b0,
+                                                    vtkDataArray& b1,
+                                                    double const w)
+{
+    auto const n_components = b0.GetNumberOfComponents();
+    auto result = vtkSmartPointer<vtkDoubleArray>::New();
+    result->SetName(b0.GetName());
+    result->SetNumberOfComponents(n_components);
+    result->SetNumberOfTuples(b0.GetNumberOfTuples());
+    double* const values = result->GetPointer(0);
+
+    parallelForChunks(b0.GetNumberOfTuples(), mesh_chunk_size,
+                      [&](std::int64_t, vtkIdType const begin,
+                          vtkIdType const end) {
+                          for (vtkIdType t = begin; t < end; ++t)
+                          {
+                              for (int c = 0; c < n_components; ++c)
+                              {
+                                  values[t * n_components + c] =
+                                      (1 - w) * b0.GetComponent(t, c) +
+                                      w * b1.GetComponent(t, c);
+                              }
+                          }
+                      });
+    return result;
+}
+
+/// Compares the meshes of each step of the first time series and of its
+/// bracketing steps in the second one. The geometry of most series does not
+/// change between steps, so the raw points and cells of each step are hashed
+/// and a pair of steps hashing like an already checked pair reuses its
+/// verdict without being decoded. Steps with identical raw geometry pass
+/// without being decoded, too.
+int compareTimeSeriesMeshes(Args const& args,
+                            std::vector<TimeStep> const& steps_a,
+                            std::vector<TimeStep> const& steps_b)
+{
+    bool const trace = args.verbose && !args.quiet;
+
+    std::map<std::string, std::optional<std::uint64_t>> geometry_hashes;
+    auto const geometry_hash = [&](std::string const& filename) {
+        auto const it = geometry_hashes.find(filename);
+        if (it != geometry_hashes.end())
+        {
+            return it->second;
+        }
+        return geometry_hashes[filename] = rawGeometryHash(filename);
+    };
+    std::map<std::pair<std::uint64_t, std::uint64_t>, bool> verdicts;
+
+    std::size_t n_failed = 0;
+    std::size_t n_decoded = 0;
+    for (auto const& step_a : steps_a)
+    {
+        auto const bracket = bracketingSteps(steps_b, step_a.time);
+        if (!bracket)
+        {
+            std::cerr << "Error: Time " << step_a.time
+                      << " is not covered by the second time series.\n";
+            return EXIT_FAILURE;
+        }
+
+        bool equal = true;
+        for (auto k = bracket->first; k <= bracket->second; ++k)
+        {
+            auto const& filename_b = steps_b[k].filename;
+            if (filename_b == step_a.filename)
+                continue;
+
+            auto const hash_a = geometry_hash(step_a.filename);
+            auto const hash_b = geometry_hash(filename_b);
+            std::optional<std::pair<std::uint64_t, std::uint64_t>> key;
+            if (hash_a && hash_b)
+                key = std::make_pair(*hash_a, *hash_b);
+
+            if (key && (key->first == key->second || verdicts.count(*key)))
+            {
+                bool const identical = key->first == key->second;
+                if (trace)
+                    std::cout << "Meshes of `" << step_a.filename << "' and `"
+                              << filename_b << "' are "
+                              << (identical ? "identical in the file"
+                                            : "checked already")
+                              << ", not decoded.\n";
+                equal = equal && (identical || verdicts[*key]);
+                continue;
+            }
+
+            auto const meshes = readMeshes(step_a.filename, filename_b, {}, {});
+            bool const verdict =
+                compareMeshes(args, std::get<0>(meshes), std::get<1>(meshes));
+            n_decoded++;
+            if (key)
+                verdicts[*key] = verdict;
+            equal = equal && verdict;
+        }
+
+        if (!equal)
+        {
+            n_failed++;
+            if (!args.quiet)
+                std::cout << "time " << step_a.time << ": meshes differ\n";
+        }
+    }
+
+    if (trace)
+        std::cout << "Decoded " << n_decoded << " pairs of meshes for "
+                  << steps_a.size() << " time steps.\n";
+    if (n_failed > 0)
+    {
+        if (!args.quiet)
+            std::cout << "Meshes differ in " << n_failed << " of "
+                      << steps_a.size() << " time steps.\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+/// Compares a data array in two .pvd time series. For each step of the first
+/// series the second one is linearly interpolated in time between its
+/// bracketing steps, of which at most two are kept in memory. The next step
+/// of the first series is read while the current one is compared.
+int compareTimeSeries(Args const& args)
+{
+    auto const series_a = readPvd(args.vtk_input_a);
+    auto const series_b = readPvd(
+        args.vtk_input_b.empty() ? args.vtk_input_a : args.vtk_input_b);
+    if (!series_a || !series_b || series_a->empty() || series_b->empty())
+    {
+        std::cerr << "Error: Could not read the time series from `"
+                  << args.vtk_input_a << "' and `" << args.vtk_input_b
+                  << "'.\n";
+        return EXIT_FAILURE;
+    }
+
+    if (args.meshcheck)
+    {
+        return compareTimeSeriesMeshes(args, *series_a, *series_b);
+    }
+
+    if (!args.quiet)
+        std::cout << "Comparing data array `" << args.data_array_a
+                  << "' from time series `" << args.vtk_input_a
+                  << "' to data array `" << args.data_array_b
+                  << "' from time series `" << args.vtk_input_b << "'.\n";
+
+    auto const& steps_a = *series_a;
+    auto const& steps_b = *series_b;
+
+    // The meshes are only kept for matching their order.
+    struct Step
+    {
+        vtkSmartPointer<vtkDataArray> array;
+        bool point_data;
+        vtkSmartPointer<vtkUnstructuredGrid> mesh;
+    };
+    auto const read_step = [&](std::string const& filename,
+                               std::string const& name,
+                               std::optional<bool> const association,
+                               bool const cross_association) {
+        Step step;
+        std::tie(step.array, step.point_data) = readStepDataArray(
+            filename, name, association, cross_association,
+            args.match_order ? &step.mesh : nullptr);
+        return step;
+    };
+
+    std::optional<bool> point_data;
+    std::map<std::size_t, Step> window_b;
+    auto const step_b = [&](std::size_t const k) {
+        if (window_b.count(k) == 0)
+        {
+            window_b[k] = read_step(steps_b[k].filename, args.data_array_b,
+                                    point_data, args.cross_association);
+        }
+        return window_b[k];
+    };
+
+    auto const read_a = [&](std::size_t const i) {
+        return read_step(steps_a[i].filename, args.data_array_a, std::nullopt,
+                         false);
+    };
+    auto next_a = readAsync([&]() { return read_a(0); });
+
+    std::vector<ErrorNorms> step_norms;
+    std::size_t n_failed = 0;
+    for (std::size_t i = 0; i < steps_a.size(); ++i)
+    {
+        auto const step_a = next_a.get();
+        auto const& a = step_a.array;
+        if (i + 1 < steps_a.size())
+        {
+            next_a = readAsync([&, i]() { return read_a(i + 1); });
+        }
+        if (!a)
+        {
+            return EXIT_FAILURE;
+        }
+        if (!point_data)
+        {
+            point_data = step_a.point_data;
+        }
+
+        double const t = steps_a[i].time;
+        auto const bracket = bracketingSteps(steps_b, t);
+        if (!bracket)
+        {
+            std::cerr << "Error: Time " << t
+                      << " is not covered by the second time series.\n";
+            return EXIT_FAILURE;
+        }
+        auto const [k0, k1] = *bracket;
+        for (auto it = window_b.begin(); it != window_b.end();)
+        {
+            it = it->first < k0 ? window_b.erase(it) : std::next(it);
+        }
+
+        // The bracketing steps may have different meshes, each is matched
+        // with its own before interpolating.
+        auto const matched_step_b = [&](std::size_t const k) {
+            auto const step = step_b(k);
+            if (!step.array || !args.match_order)
+            {
+                return step.array;
+            }
+            return matchDataArray(args, step_a.mesh, step.mesh, *step.array,
+                                  *point_data);
+        };
+        auto b = matched_step_b(k0);
+        if (!b)
+        {
+            return EXIT_FAILURE;
+        }
+        if (k1 != k0)
+        {
+            auto const b1 = matched_step_b(k1);
+            if (!b1 || !checkDataArrayShapes(*b, *b1))
+            {
+                return EXIT_FAILURE;
+            }
+            double const w =
+                (t - steps_b[k0].time) / (steps_b[k1].time - steps_b[k0].time);
+            b = interpolateDataArrays(*b, *b1, w);
+        }
+
+        if (!checkDataArrayShapes(*a, *b) || !checkSelectedComponents(args, *a))
+        {
+            return EXIT_FAILURE;
+        }
+        step_norms.push_back(computeErrorNorms(*a, *b, args));
+        bool const failed = step_norms.back().exceedThresholds(args);
+        n_failed += failed ? 1 : 0;
+        Metrics::instance().addComparison(args.data_array_a,
+                                          selectedComponents(args, *a),
+                                          step_norms.back(), failed);
+
+        if (!args.quiet)
+        {
+            std::cout << "time " << t << ": abs maximum norm = "
+                      << step_norms.back().abs_err_norm_max
+                      << ", rel maximum norm = "
+                      << step_norms.back().rel_err_norm_max
+                      << (failed ? " (exceeds thresholds)" : "") << "\n";
+        }
+    }
+
+    // Space-time norms: trapezoidal L2 norm in time of the spatial l2 norms,
+    // and the maximum over time of the spatial maximum norms.
+    auto const n_components = step_norms.front().abs_err_norm_max.size();
+    std::vector<double> abs_l2_l2(n_components), rel_l2_l2(n_components);
+    std::vector<double> abs_max_max(n_components), rel_max_max(n_components);
+    for (std::size_t i = 0; i < step_norms.size(); ++i)
+    {
+        double const weight =
+            step_norms.size() == 1
+                ? 1
+                : 0.5 * ((i + 1 < steps_a.size() ? steps_a[i + 1].time
+                                                 : steps_a[i].time) -
+                         (i > 0 ? steps_a[i - 1].time : steps_a[i].time));
+        for (std::size_t c = 0; c < n_components; ++c)
+        {
+            abs_l2_l2[c] += weight * step_norms[i].abs_err_norm_2_2[c];
+            rel_l2_l2[c] += weight * step_norms[i].rel_err_norm_2_2[c];
+            abs_max_max[c] =
+                std::max(abs_max_max[c], step_norms[i].abs_err_norm_max[c]);
+            rel_max_max[c] =
+                std::max(rel_max_max[c], step_norms[i].rel_err_norm_max[c]);
+        }
+    }
+    for (std::size_t c = 0; c < n_components; ++c)
+    {
+        abs_l2_l2[c] = std::sqrt(abs_l2_l2[c]);
+        rel_l2_l2[c] = std::sqrt(rel_l2_l2[c]);
+    }
+
+    if (!args.quiet)
+    {
+        std::cout << "Computed space-time difference over "
+                  << step_norms.size() << " time steps:\n";
+        std::cout << "abs L2(l2)-norm      = " << abs_l2_l2 << "\n";
+        std::cout << "abs max(max)-norm    = " << abs_max_max << "\n";
+        std::cout << "rel L2(l2)-norm      = " << rel_l2_l2 << "\n";
+        std::cout << "rel max(max)-norm    = " << rel_max_max << "\n";
+    }
+
+    if (n_failed > 0)
+    {
+        if (!args.quiet)
+            std::cout << "Absolute and relative error (maximum norm) are larger"
+                         " than the corresponding thresholds "
+                      << args.abs_err_thr << " and " << args.rel_err_thr
+                      << " in " << n_failed << " time steps.\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+/// Per-value running statistics of an ensemble (Welford's algorithm).
+struct EnsembleStatistics
+{
+    explicit EnsembleStatistics(std::size_t const n_values)
+        : mean(n_values),
+          m2(n_values),
+          min(n_values, std::numeric_limits<double>::infinity()),
+          max(n_values, -std::numeric_limits<double>::infinity())
+    {
+    }
+
+    void add(vtkDataArray& array)
+    {
+        n++;
+        auto const n_components = array.GetNumberOfComponents();
+        auto& progress = Progress::instance();
+        progress.tuples_total += array.GetNumberOfTuples();
+        std::uint64_t const n_values =
+            array.GetNumberOfTuples() * n_components;
+        progress.compare.bytes += n_values * array.GetDataTypeSize();
+        ScopedTimer const timer(progress.compare);
+        parallelForChunks(
+            array.GetNumberOfTuples(), mesh_chunk_size,
+            [&](std::int64_t, vtkIdType const begin, vtkIdType const end) {
+                for (vtkIdType t = begin; t < end; ++t)
+                {
+                    for (int c = 0; c < n_components; ++c)
+                    {
+                        auto const i = t * n_components + c;
+                        double const x = array.GetComponent(t, c);
+                        double const delta = x - mean[i];
+                        mean[i] += delta / n;
+                        m2[i] += delta * (x - mean[i]);
+                        min[i] = std::min(min[i], x);
+                        max[i] = std::max(max[i], x);
+                    }
+                }
+                progress.tuples_compared.fetch_add(end - begin,
+                                                   std::memory_order_relaxed);
+            });
+    }
+
+    /// Sample variance.
+    double variance(std::size_t const i) const
+    {
+        return n > 1 ? m2[i] / (n - 1) : 0;
+    }
+
+    std::size_t n = 0;
+    std::vector<double> mean;
+    std::vector<double> m2;
+    std::vector<double> min;
+    std::vector<double> max;
+};
+
+/// Writes the first member's mesh with the statistics as additional data
+/// arrays. Returns false if the file could not be written.
+bool writeEnsembleStatistics(Args const& args, EnsembleStatistics const& stats,
+                             bool const point_data, int const n_components)
+{
+    auto const mesh = readMesh(args.vtk_input_a, {});
+    if (mesh == nullptr)
+    {
+        return false;
+    }
+
+    auto const add_field = [&](std::string const& suffix, auto const& value) {
+        auto array = vtkSmartPointer<vtkDoubleArray>::New();
+        array->SetName((args.data_array_a + suffix).c_str());
+        array->SetNumberOfComponents(n_components);
+        array->SetNumberOfTuples(stats.mean.size() / n_components);
+        for (std::size_t i = 0; i < stats.mean.size(); ++i)
+        {
+            array->GetPointer(0)[i] = value(i);
+        }
+        if (point_data)
+            mesh->GetPointData()->AddArray(array);
+        else
+            mesh->GetCellData()->AddArray(array);
+    };
+    add_field("_mean", [&](std::size_t i) { return stats.mean[i]; });
+    add_field("_stddev",
+              [&](std::size_t i) { return std::sqrt(stats.variance(i)); });
+    add_field("_min", [&](std::size_t i) { return stats.min[i]; });
+    add_field("_max", [&](std::size_t i) { return stats.max[i]; });
+
+    auto writer = vtkSmartPointer<vtkXMLUnstructuredGridWriter>::New();
+    writer->SetFileName(args.ensemble_output.c_str());
+    writer->SetInputData(mesh);
+    if (writer->Write() == 0)
+    {
+        std::cerr << "Error: Could not write file `" << args.ensemble_output
+                  << "'.\n";
+        return false;
+    }
+    return true;
+}
+
+/// Computes per-value statistics of a data array over an ensemble of runs,
+/// reading one run at a time while the previous one is accumulated.
+int compareEnsemble(Args const& args)
+{
+    std::vector<std::string> members{args.vtk_input_a};
+    if (!args.vtk_input_b.empty())
+        members.push_back(args.vtk_input_b);
+    members.insert(members.end(), args.ensemble.begin(), args.ensemble.end());
+
+    if (!args.quiet)
+        std::cout << "Computing ensemble statistics of data array `"
+                  << args.data_array_a << "' over " << members.size()
+                  << " files.\n";
+
+    std::optional<bool> point_data;
+    auto const read = [&](std::size_t const i) {
+        return std::get<0>(readStepDataArray(members[i], args.data_array_a,
+                                              point_data,
+                                              args.cross_association));
+    };
+
+    auto [first, first_point_data] = readStepDataArray(
+        members[0], args.data_array_a, std::nullopt, false);
+    if (!first || !checkDataArrayShapes(*first, *first))
+    {
+        return EXIT_FAILURE;
+    }
+    point_data = first_point_data;
+    auto const n_tuples = first->GetNumberOfTuples();
+    auto const n_components = first->GetNumberOfComponents();
+
+    EnsembleStatistics stats(static_cast<std::size_t>(n_tuples) *
+                             n_components);
+    std::optional<AsyncRead<vtkSmartPointer<vtkDataArray>>> next;
+    if (members.size() > 1)
+    {
+        next = readAsync([&]() { return read(1); });
+    }
+    stats.add(*first);
+    first = nullptr;
+
+    for (std::size_t i = 1; i < members.size(); ++i)
+    {
+        auto const array = next->get();
+        if (i + 1 < members.size())
+        {
+            next = readAsync([&, i]() { return read(i + 1); });
+        }
+        if (!array)
+        {
+            return EXIT_FAILURE;
+        }
+        if (array->GetNumberOfTuples() != n_tuples ||
+            array->GetNumberOfComponents() != n_components)
+        {
+            std::cerr << "Error: Data array in file `" << members[i]
+                      << "' has " << array->GetNumberOfTuples()
+                      << " tuples and " << array->GetNumberOfComponents()
+                      << " components, but " << n_tuples << " and "
+                      << n_components << " are expected.\n";
+            return EXIT_FAILURE;
+        }
+        stats.add(*array);
+    }
+
+    // Spread norms per component: largest range, largest relative range,
+    // largest and root mean square standard deviation.
+    std::vector<double> abs_spread_max(n_components);
+    std::vector<double> rel_spread_max(n_components);
+    std::vector<double> stddev_max(n_components);
+    std::vector<double> stddev_rms(n_components);
+    std::vector<double> tuple_variances(n_tuples);
+    for (vtkIdType t = 0; t < n_tuples; ++t)
+    {
+        for (int c = 0; c < n_components; ++c)
+        {
+            auto const i = t * n_components + c;
+            double const abs_spread = stats.max[i] - stats.min[i];
+            double const min_abs =
+                std::min(std::abs(stats.min[i]), std::abs(stats.max[i]));
+            double const rel_spread =
+                abs_spread == 0 ? 0
+                : min_abs == 0  ? std::numeric_limits<double>::infinity()
+                                : abs_spread / min_abs;
+            abs_spread_max[c] = std::max(abs_spread_max[c], abs_spread);
+            rel_spread_max[c] = std::max(rel_spread_max[c], rel_spread);
+            stddev_max[c] =
+                std::max(stddev_max[c], std::sqrt(stats.variance(i)));
+            stddev_rms[c] += stats.variance(i);
+            tuple_variances[t] += stats.variance(i);
+        }
+    }
+    for (auto& value : stddev_rms)
+    {
+        value = n_tuples > 0 ? std::sqrt(value / n_tuples) : 0;
+    }
+
+    if (!args.quiet)
+    {
+        std::cout << "abs spread maximum norm = " << abs_spread_max << "\n";
+        std::cout << "rel spread maximum norm = " << rel_spread_max << "\n";
+        std::cout << "stddev maximum norm     = " << stddev_max << "\n";
+        std::cout << "stddev rms              = " << stddev_rms << "\n";
+
+        std::vector<vtkIdType> largest(n_tuples);
+        std::iota(largest.begin(), largest.end(), 0);
+        auto const n_largest = std::min<vtkIdType>(10, n_tuples);
+        std::partial_sort(largest.begin(), largest.begin() + n_largest,
+                          largest.end(), [&](vtkIdType x, vtkIdType y) {
+                              return tuple_variances[x] > tuple_variances[y];
+                          });
+        std::cout << "Tuples with the largest variance:\n";
+        for (vtkIdType k = 0; k < n_largest; ++k)
+        {
+            std::cout << "  tuple " << largest[k] << ": variance "
+                      << tuple_variances[largest[k]] << "\n";
+        }
+    }
+
+    if (!args.ensemble_output.empty() &&
+        !writeEnsembleStatistics(args, stats, *point_data, n_components))
+    {
+        return EXIT_FAILURE;
+    }
+
+    if (*std::max_element(abs_spread_max.begin(), abs_spread_max.end()) >
+            args.abs_err_thr &&
+        *std::max_element(rel_spread_max.begin(), rel_spread_max.end()) >
+            args.rel_err_thr)
+    {
+        if (!args.quiet)
+            std::cout << "Absolute and relative spread (maximum norm) are "
+                         "larger than the corresponding thresholds "
+                      << args.abs_err_thr << " and " << args.rel_err_thr
+                      << ".\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+/// Fractions of the sorted values whose order statistics are stored in a
+/// signature.
+constexpr std::array<double, 9> signature_quantiles{
+    0.001, 0.01, 0.05, 0.25, 0.5, 0.75, 0.95, 0.99, 0.999};
+
+/// Maximum number of blocks of consecutive tuples summarized in a signature.
+constexpr vtkIdType signature_blocks = 256;
+
+/// Summary of the values of one component of a data array.
+struct ComponentSignature
+{
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+    double mean = 0;
+    double standard_deviation = 0;
+    double norm_l1 = 0;
+    double norm_l2 = 0;
+    double norm_max = 0;
+    std::array<double, signature_quantiles.size()> quantiles{};
+};
+
+/// Minimum, maximum and mean per component of a block of consecutive tuples
+/// and the hash of its values.
+struct BlockSignature
+{
+    std::uint64_t hash = 0;
+    std::vector<double> min;
+    std::vector<double> max;
+    std::vector<double> mean;
+};
+
+/// Compact numeric fingerprint of a data array. Lower bounds of the errors
+/// between two arrays are derived from their signatures.
+struct ArraySignature
+{
+    std::string name;
+    bool point_data = true;
+    vtkIdType number_of_tuples = 0;
+    int number_of_components = 0;
+    vtkIdType block_tuples = 1;
+    std::uint64_t hash = 0;
+    std::vector<ComponentSignature> components;
+    std::vector<BlockSignature> blocks;
+};
+
+/// Computes the signature of an array in one parallel pass over its blocks
+/// of block_tuples tuples, followed by a selection of the quantiles of each
+/// component. Blocks are merged in order, so the signature does not depend
+/// on the number of threads. NaN values are not counted in the order
+/// statistics.
+ArraySignature computeArraySignature(vtkDataArray& array,
+                                     std::string const& name,
+                                     bool const point_data,
+                                     vtkIdType const block_tuples)
+{
+    auto const n_tuples = array.GetNumberOfTuples();
+    int const n_components = array.GetNumberOfComponents();
+    vtkIdType const n_blocks = (n_tuples + block_tuples - 1) / block_tuples;
+
+    ArraySignature signature;
+    signature.name = name;
+    signature.point_data = point_data;
+    signature.number_of_tuples = n_tuples;
+    signature.number_of_components = n_components;
+    signature.block_tuples = block_tuples;
+    signature.components.resize(n_components);
+    signature.blocks.resize(n_blocks);
+
+    // Per block and component: sum of squared deviations from the block's
+    // mean, l1 norm, squared l2 norm and maximum norm.
+    std::vector<std::array<double, 4>> block_sums(n_blocks * n_components);
+    parallelForChunks(
+        n_tuples, block_tuples,
+        [&](std::int64_t const chunk, vtkIdType const begin,
+            vtkIdType const end) {
+            auto& block = signature.blocks[chunk];
+            block.min.resize(n_components);
+            block.max.resize(n_components);
+            block.mean.resize(n_components);
+            std::vector<std::uint64_t> hashes(n_components);
+            std::vector<double> buffer;
+            std::vector<double> values(end - begin);
+            for (int c = 0; c < n_components; ++c)
+            {
+                auto const view = componentView(array, c, begin, end, buffer);
+                std::visit(
+                    [&](auto const* const data) {
+                        for (vtkIdType i = 0; i < end - begin; ++i)
+                            values[i] = data[i * view.stride];
+                    },
+                    view.data);
+
+                double min = std::numeric_limits<double>::infinity();
+                double max = -std::numeric_limits<double>::infinity();
+                double sum = 0, l1 = 0, l2_2 = 0, norm_max = 0;
+                for (double const v : values)
+                {
+                    min = std::min(min, v);
+                    max = std::max(max, v);
+                    sum += v;
+                    l1 += std::abs(v);
+                    l2_2 += v * v;
+                    norm_max = std::max(norm_max, std::abs(v));
+                }
+                double const mean = sum / values.size();
+                double m2 = 0;
+                for (double const v : values)
+                    m2 += (v - mean) * (v - mean);
+
+                block.min[c] = min;
+                block.max[c] = max;
+                block.mean[c] = mean;
+                block_sums[chunk * n_components + c] = {m2, l1, l2_2,
+                                                        norm_max};
+                hashes[c] = hashBytes(values.data(),
+                                      values.size() * sizeof(double));
+            }
+            block.hash = hashBytes(hashes.data(),
+                                   hashes.size() * sizeof(hashes[0]));
+        });
+
+    std::vector<std::uint64_t> block_hashes;
+    for (vtkIdType j = 0; j < n_blocks; ++j)
+    {
+        block_hashes.push_back(signature.blocks[j].hash);
+    }
+    signature.hash = hashBytes(block_hashes.data(),
+                               block_hashes.size() * sizeof(block_hashes[0]));
+
+    std::vector<double> column(n_tuples);
+    for (int c = 0; c < n_components; ++c)
+    {
+        auto& component = signature.components[c];
+
+        // Means and squared deviations are merged pairwise (Chan et al.).
+        double count = 0, m2 = 0;
+        for (vtkIdType j = 0; j < n_blocks; ++j)
+        {
+            auto const& block = signature.blocks[j];
+            auto const& [block_m2, l1, l2_2, norm_max] =
+                block_sums[j * n_components + c];
+            double const block_count = static_cast<double>(
+                std::min(block_tuples, n_tuples - j * block_tuples));
+            double const delta = block.mean[c] - component.mean;
+            component.mean += delta * block_count / (count + block_count);
+            m2 += block_m2 + delta * delta * count * block_count /
+                                 (count + block_count);
+            count += block_count;
+
+            component.min = std::min(component.min, block.min[c]);
+            component.max = std::max(component.max, block.max[c]);
+            component.norm_l1 += l1;
+            component.norm_l2 += l2_2;
+            component.norm_max = std::max(component.norm_max, norm_max);
+        }
+        component.norm_l2 = std::sqrt(component.norm_l2);
+        component.standard_deviation =
+            count > 0 ? std::sqrt(m2 / count) : 0.;
+
+        parallelForChunks(
+            n_tuples, mesh_chunk_size,
+            [&](std::int64_t, vtkIdType const begin, vtkIdType const end) {
+                std::vector<double> buffer;
+                auto const view = componentView(array, c, begin, end, buffer);
+                std::visit(
+                    [&](auto const* const data) {
+                        for (vtkIdType t = begin; t < end; ++t)
+                            column[t] = data[(t - begin) * view.stride];
+                    },
+                    view.data);
+            });
+        auto const values_end =
+            std::remove_if(column.begin(), column.end(),
+                           [](double const v) { return std::isnan(v); });
+        auto const n_values = values_end - column.begin();
+        if (n_values == 0)
+            continue;
+
+        // Ascending ranks, each selected in the remaining upper part.
+        auto lower = column.begin();
+        for (std::size_t q = 0; q < signature_quantiles.size(); ++q)
+        {
+            auto const nth =
+                column.begin() +
+                static_cast<std::ptrdiff_t>(signature_quantiles[q] *
+                                            (n_values - 1));
+            std::nth_element(lower, nth, values_end);
+            component.quantiles[q] = *nth;
+            lower = nth;
+        }
+    }
+    return signature;
+}
+
+/// Writes signatures to a text file, atomically replacing the file.
+bool writeSignatureFile(std::string const& path,
+                        std::vector<ArraySignature> const& signatures)
+{
+    std::random_device random;
+    auto const temporary_path = path + "." + toHexString(random()) + ".tmp";
+    std::error_code error;
+    {
+        std::ofstream file(temporary_path);
+        file << std::setprecision(std::numeric_limits<double>::max_digits10)
+             << "vtkdiff-signature 1\n";
+        for (auto const& signature : signatures)
+        {
+            file << "array " << (signature.point_data ? "point" : "cell")
+                 << " " << signature.number_of_tuples << " "
+                 << signature.number_of_components << " "
+                 << signature.block_tuples << " "
+                 << toHexString(signature.hash) << " "
+                 << signature.blocks.size() << "\n"
+                 << signature.name << "\n";
+            for (auto const& component : signature.components)
+            {
+                file << "component " << component.min << " " << component.max
+                     << " " << component.mean << " "
+                     << component.standard_deviation << " "
+                     << component.norm_l1 << " " << component.norm_l2 << " "
+                     << component.norm_max;
+                for (double const quantile : component.quantiles)
+                    file << " " << quantile;
+                file << "\n";
+            }
+            for (auto const& block : signature.blocks)
+            {
+                file << "block " << toHexString(block.hash);
+                for (int c = 0; c < signature.number_of_components; ++c)
+                    file << " " << block.min[c] << " " << block.max[c] << " "
+                         << block.mean[c];
+                file << "\n";
+            }
+        }
+        if (!file)
+        {
+            file.close();
+            std::filesystem::remove(temporary_path, error);
+            return false;
+        }
+    }
+    std::filesystem::rename(temporary_path, path, error);
+    if (error)
+    {
+        std::filesystem::remove(temporary_path, error);
+        return false;
+    }
+    return true;
+}
+
+/// Reads the signatures written by writeSignatureFile().
+std::optional<std::vector<ArraySignature>> readSignatureFile(
+    std::string const& path)
 {
-    return {readMesh(file_a_name), readMesh(file_b_name)};
+    std::ifstream file(path);
+    std::string line;
+    if (!std::getline(file, line) || line != "vtkdiff-signature 1")
+    {
+        return std::nullopt;
+    }
+
+    // Numbers are read as words; parseDouble() also accepts inf, nan and
+    // subnormal values. Reading stops at the first invalid word.
+    std::string word;
+    bool valid = true;
+    auto const next_word = [&]() -> std::string const& {
+        if (!valid || !(file >> word))
+        {
+            valid = false;
+            word.clear();
+        }
+        return word;
+    };
+    auto const next_number = [&]() {
+        auto const value = parseDouble(next_word());
+        valid = valid && value.has_value();
+        return value.value_or(0.);
+    };
+    auto const next_integer = [&]() {
+        auto const value = parseInteger<std::int64_t>(next_word());
+        valid = valid && value.has_value();
+        return value.value_or(0);
+    };
+    auto const next_hash = [&]() {
+        auto const value = parseInteger<std::uint64_t>(next_word(), 16);
+        valid = valid && value.has_value();
+        return value.value_or(0);
+    };
+    auto const next_keyword = [&](char const* const keyword) {
+        valid = next_word() == keyword;
+    };
+
+    std::vector<ArraySignature> signatures;
+    while (file >> word)
+    {
+        if (word != "array")
+            return std::nullopt;
+        ArraySignature signature;
+        signature.point_data = next_word() == "point";
+        signature.number_of_tuples = next_integer();
+        signature.number_of_components =
+            static_cast<int>(next_integer());
+        signature.block_tuples = next_integer();
+        signature.hash = next_hash();
+        auto const n_blocks = next_integer();
+        file.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        if (!valid || !std::getline(file, signature.name) ||
+            signature.number_of_tuples < 0 ||
+            signature.number_of_components < 1 ||
+            signature.block_tuples < 1 ||
+            n_blocks != (signature.number_of_tuples +
+                         signature.block_tuples - 1) /
+                            signature.block_tuples)
+        {
+            return std::nullopt;
+        }
+
+        for (int c = 0; c < signature.number_of_components && valid; ++c)
+        {
+            ComponentSignature component;
+            next_keyword("component");
+            component.min = next_number();
+            component.max = next_number();
+            component.mean = next_number();
+            component.standard_deviation = next_number();
+            component.norm_l1 = next_number();
+            component.norm_l2 = next_number();
+            component.norm_max = next_number();
+            for (double& quantile : component.quantiles)
+                quantile = next_number();
+            signature.components.push_back(component);
+        }
+        for (std::int64_t j = 0; j < n_blocks && valid; ++j)
+        {
+            BlockSignature block;
+            next_keyword("block");
+            block.hash = next_hash();
+            for (int c = 0; c < signature.number_of_components; ++c)
+            {
+                block.min.push_back(next_number());
+                block.max.push_back(next_number());
+                block.mean.push_back(next_number());
+            }
+            signature.blocks.push_back(std::move(block));
+        }
+        if (!valid)
+        {
+            return std::nullopt;
+        }
+        signatures.push_back(std::move(signature));
+    }
+    return signatures;
 }
 
-std::tuple<bool, vtkSmartPointer<vtkDataArray>, vtkSmartPointer<vtkDataArray>>
-readDataArraysFromMeshes(
-    std::tuple<vtkSmartPointer<vtkUnstructuredGrid>,
-               vtkSmartPointer<vtkUnstructuredGrid>> const& meshes,
-    std::string const& data_array_a_name,
-    std::string const& data_array_b_name)
+/// Lower bounds of the error norms between an array and a reference array
+/// given by signatures with equal blocks. Every statistic t used satisfies
+/// |t(a) - t(b)| <= max_i |a_i - b_i| with a witness i whose values are
+/// bounded by the statistic's magnitude, from which the relative error is
+/// bounded. Each block's difference of means also bounds its contribution to
+/// the l1 and l2 norms. Sums are allowed their worst-case rounding error.
+ErrorNorms signatureErrorLowerBounds(ArraySignature const& a,
+                                     ArraySignature const& b,
+                                     std::vector<int> const& components)
 {
-    if (std::get<0>(meshes) == nullptr)
+    auto const bound = [](double const x, double const y,
+                          double const allowance) {
+        double const d = std::abs(x - y) - allowance;
+        return d > 0 ? d : 0.;
+    };
+    auto const relative = [](double const d, double const magnitude) {
+        if (d == 0)
+            return 0.;
+        if (magnitude == 0)
+            return std::numeric_limits<double>::infinity();
+        return d / magnitude;
+    };
+    double const epsilon = std::numeric_limits<double>::epsilon();
+    double const n = static_cast<double>(a.number_of_tuples);
+
+    ErrorNorms norms(components.size());
+    for (std::size_t k = 0; k < components.size(); ++k)
     {
-        std::cerr << "First mesh was not read correctly and is a nullptr.\n";
-        return {false, nullptr, nullptr};
+        auto const c = components[k];
+        auto const& ca = a.components[c];
+        auto const& cb = b.components[c];
+        double abs_max = 0, rel_max = 0;
+        auto const witness = [&](double const d, double const magnitude) {
+            abs_max = std::max(abs_max, d);
+            rel_max = std::max(rel_max, relative(d, magnitude));
+        };
+
+        double const magnitude = std::max(ca.norm_max, cb.norm_max);
+        double const allowance = 2 * n * epsilon * magnitude;
+        witness(bound(ca.norm_max, cb.norm_max, 0), magnitude);
+        witness(bound(ca.mean, cb.mean, allowance), magnitude);
+        witness(bound(ca.standard_deviation, cb.standard_deviation,
+                      allowance),
+                magnitude);
+        for (std::size_t q = 0; q < signature_quantiles.size(); ++q)
+            witness(bound(ca.quantiles[q], cb.quantiles[q], 0), magnitude);
+
+        double block_l1 = 0, block_l2_2 = 0;
+        for (vtkIdType j = 0; j < static_cast<vtkIdType>(a.blocks.size());
+             ++j)
+        {
+            auto const& ba = a.blocks[j];
+            auto const& bb = b.blocks[j];
+            double const count = static_cast<double>(std::min(
+                a.block_tuples, a.number_of_tuples - j * a.block_tuples));
+            double const block_magnitude =
+                std::max({std::abs(ba.min[c]), std::abs(ba.max[c]),
+                          std::abs(bb.min[c]), std::abs(bb.max[c])});
+            witness(bound(ba.min[c], bb.min[c], 0), block_magnitude);
+            witness(bound(ba.max[c], bb.max[c], 0), block_magnitude);
+            double const d_mean = bound(ba.mean[c], bb.mean[c],
+                                        2 * count * epsilon * block_magnitude);
+            witness(d_mean, block_magnitude);
+            block_l1 += count * d_mean;
+            block_l2_2 += count * d_mean * d_mean;
+        }
+
+        double const d_l1 =
+            bound(ca.norm_l1, cb.norm_l1,
+                  n * epsilon * std::max(ca.norm_l1, cb.norm_l1));
+        double const d_l2 =
+            bound(ca.norm_l2, cb.norm_l2,
+                  n * epsilon * std::max(ca.norm_l2, cb.norm_l2));
+        norms.abs_err_norm_l1[k] = std::max({block_l1, d_l1, abs_max});
+        norms.abs_err_norm_2_2[k] =
+            std::max({block_l2_2, d_l2 * d_l2, abs_max * abs_max});
+        norms.abs_err_norm_max[k] = abs_max;
+        norms.rel_err_norm_l1[k] = rel_max;
+        norms.rel_err_norm_2_2[k] = rel_max * rel_max;
+        norms.rel_err_norm_max[k] = rel_max;
     }
+    return norms;
+}
 
-    bool point_data(false);
-    if (std::get<0>(meshes)->GetPointData()->HasArray(
-            data_array_a_name.c_str()))
+/// Writes the signatures of data arrays a and b, if given, of the first file.
+int writeSignatures(Args const& args)
+{
+    if (!args.vtk_input_b.empty())
     {
-        point_data = true;
+        std::cerr << "Error: --write-signature reads only one file.\n";
+        return EXIT_FAILURE;
     }
-    else if (std::get<0>(meshes)->GetCellData()->HasArray(
-                 data_array_a_name.c_str()))
+
+    std::vector<std::string> names{args.data_array_a};
+    if (!args.data_array_b.empty() && args.data_array_b != args.data_array_a)
     {
-        point_data = false;
+        names.push_back(args.data_array_b);
     }
-    else
+    auto const mesh = readMesh(args.vtk_input_a, names);
+    if (mesh == nullptr)
     {
-        std::cerr << "Error: Scalars data array "
-                  << "\'" << data_array_a_name.c_str() << "\'"
-                  << " neither found in point data nor in cell data.\n";
-        return std::make_tuple(false, nullptr, nullptr);
+        return EXIT_FAILURE;
     }
 
-    // Get arrays
-    vtkSmartPointer<vtkDataArray> a;
-    if (point_data)
+    std::vector<ArraySignature> signatures;
+    for (auto const& name : names)
     {
-        a = vtkSmartPointer<vtkDataArray>{
-            std::get<0>(meshes)->GetPointData()->GetScalars(
-                data_array_a_name.c_str())};
+        bool const point_data =
+            mesh->GetPointData()->HasArray(name.c_str()) != 0;
+        auto const array = getDataArray(mesh, name, point_data);
+        if (!array)
+        {
+            std::cerr << "Error: Scalars data array "
+                      << "\'" << name << "\'"
+                      << " neither found in point data nor in cell data.\n";
+            return EXIT_FAILURE;
+        }
+        ScopedTimer const timer(Progress::instance().compare);
+        auto const n_tuples = array->GetNumberOfTuples();
+        signatures.push_back(computeArraySignature(
+            *array, name, point_data,
+            std::max<vtkIdType>(
+                1, (n_tuples + signature_blocks - 1) / signature_blocks)));
     }
-    else
+
+    if (!writeSignatureFile(args.write_signature, signatures))
     {
-        a = vtkSmartPointer<vtkDataArray>{
-            std::get<0>(meshes)->GetCellData()->GetScalars(
-                data_array_a_name.c_str())};
+        std::cerr << "Error: Could not write the signature file `"
+                  << args.write_signature << "'.\n";
+        return EXIT_FAILURE;
+    }
+    if (!args.quiet)
+        std::cout << "Wrote the signature of " << names.size()
+                  << " data arrays of file `" << args.vtk_input_a
+                  << "' to `" << args.write_signature << "'.\n";
+    return EXIT_SUCCESS;
+}
+
+/// Compares data array a of the first file to the signature of data array b,
+/// or a if b is not given. Only the first file is read; the comparison fails
+/// if lower bounds of both maximum norms exceed the thresholds.
+int compareToSignature(Args const& args)
+{
+    if (!args.vtk_input_b.empty())
+    {
+        std::cerr << "Error: --against-signature reads only one file.\n";
+        return EXIT_FAILURE;
     }
 
-    // Check arrays' validity
+    auto const signatures = readSignatureFile(args.against_signature);
+    if (!signatures)
+    {
+        std::cerr << "Error: Could not read the signature file `"
+                  << args.against_signature << "'.\n";
+        exitProgram(2);
+    }
+    auto const& name_b =
+        args.data_array_b.empty() ? args.data_array_a : args.data_array_b;
+    auto const reference = std::find_if(
+        signatures->begin(), signatures->end(),
+        [&](ArraySignature const& signature) {
+            return signature.name == name_b;
+        });
+    if (reference == signatures->end())
+    {
+        std::cerr << "Error: Data array `" << name_b
+                  << "' not found in the signature file `"
+                  << args.against_signature << "'.\n";
+        return EXIT_FAILURE;
+    }
+
+    auto const [a, point_data] =
+        readStepDataArray(args.vtk_input_a, args.data_array_a,
+                          reference->point_data, args.cross_association);
     if (!a)
     {
-        std::cerr << "Error: Scalars data array "
-                  << "\'" << data_array_a_name.c_str() << "\'"
-                  << " could not be read.\n";
-        return std::make_tuple(false, nullptr, nullptr);
+        return EXIT_FAILURE;
     }
+    if (!args.quiet)
+        std::cout << "Comparing data array `" << args.data_array_a
+                  << "' from file `" << args.vtk_input_a
+                  << "' to the signature of data array `" << name_b
+                  << "' from `" << args.against_signature << "'.\n";
 
-    vtkSmartPointer<vtkDataArray> b;
-    if (std::get<1>(meshes) == nullptr)
+    if (a->GetNumberOfTuples() != reference->number_of_tuples)
     {
-        if (data_array_a_name == data_array_b_name)
+        std::cerr << "Number of tuples differ:\n"
+                  << a->GetNumberOfTuples() << " in data array a and "
+                  << reference->number_of_tuples << " in data array b\n";
+        return EXIT_FAILURE;
+    }
+    if (a->GetNumberOfComponents() != reference->number_of_components)
+    {
+        std::cerr << "Number of components differ:\n"
+                  << a->GetNumberOfComponents() << " in data array a and "
+                  << reference->number_of_components << " in data array b\n";
+        return EXIT_FAILURE;
+    }
+    if (!checkSelectedComponents(args, *a))
+    {
+        return EXIT_FAILURE;
+    }
+
+    ArraySignature candidate;
+    {
+        ScopedTimer const timer(Progress::instance().compare);
+        candidate = computeArraySignature(*a, args.data_array_a, point_data,
+                                          reference->block_tuples);
+    }
+    auto const components = selectedComponents(args, *a);
+    auto const norms =
+        signatureErrorLowerBounds(candidate, *reference, components);
+    bool const failed = norms.exceedThresholds(args);
+    Metrics::instance().addComparison(args.data_array_a, components, norms,
+                                      failed);
+
+    if (!args.quiet)
+    {
+        if (candidate.hash == reference->hash)
         {
-            std::cerr << "Error: You are trying to compare data array `"
-                      << data_array_a_name
-                      << "' from first file to itself. Aborting.\n";
-            std::exit(3);
+            std::cout << "The data arrays' values are identical.\n";
         }
-        if (point_data)
+        if (args.verbose)
         {
-            b = vtkSmartPointer<vtkDataArray>{
-                std::get<0>(meshes)->GetPointData()->GetScalars(
-                    data_array_b_name.c_str())};
+            std::size_t n_identical = 0;
+            for (std::size_t j = 0; j < candidate.blocks.size(); ++j)
+            {
+                n_identical +=
+                    candidate.blocks[j].hash == reference->blocks[j].hash ? 1
+                                                                          : 0;
+            }
+            std::cout << n_identical << " of " << candidate.blocks.size()
+                      << " blocks of " << reference->block_tuples
+                      << " tuples are identical.\n";
         }
-        else
+        printErrorNorms(norms,
+                        "Lower bounds of the difference between data arrays "
+                        "implied by their signatures:");
+    }
+
+    if (failed)
+    {
+        if (!args.quiet)
+            std::cout << "Absolute and relative error (maximum norm) are at "
+                         "least "
+                      << *std::max_element(norms.abs_err_norm_max.begin(),
+                                           norms.abs_err_norm_max.end())
+                      << " and "
+                      << *std::max_element(norms.rel_err_norm_max.begin(),
+                                           norms.rel_err_norm_max.end())
+                      << ", larger than the corresponding thresholds "
+                      << args.abs_err_thr << " and " << args.rel_err_thr
+                      << ".\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+/// Scans the headers of the .vtu files in a directory in parallel, hashes
+/// the arrays' raw payloads and reads the block tables of compressed
+/// appended arrays, and writes the directory's catalog atomically.
+int writeIndex(Args const& args)
+{
+    auto const& directory = args.vtk_input_a;
+    std::error_code error;
+    std::vector<std::string> names;
+    for (auto const& entry :
+         std::filesystem::directory_iterator(directory, error))
+    {
+        auto const name = entry.path().filename().string();
+        if (entry.is_regular_file(error) && stringEndsWith(name, ".vtu"))
+            names.push_back(name);
+    }
+    if (error)
+    {
+        std::cerr << "Error: Could not list the directory `" << directory
+                  << "'.\n";
+        return EXIT_FAILURE;
+    }
+    std::sort(names.begin(), names.end());
+
+    struct ScannedFile
+    {
+        std::int64_t size = 0;
+        std::optional<std::int64_t> modification_time;
+        std::optional<VtuHeader> header;
+        std::vector<std::uint64_t> block_size;
+        std::vector<std::vector<std::uint64_t>> blocks;
+    };
+    std::vector<ScannedFile> scanned(names.size());
+    parallelForChunks(
+        names.size(), 1,
+        [&](std::int64_t const i, std::int64_t, std::int64_t) {
+            auto const path = (std::filesystem::path(directory) / names[i])
+                                  .string();
+            auto& result = scanned[i];
+            result.modification_time = modificationTime(path);
+            result.header = readVtuHeader(path);
+            std::ifstream file(path, std::ios::binary | std::ios::ate);
+            if (!result.modification_time || !result.header || !file)
+            {
+                result.header.reset();
+                return;
+            }
+            result.size = file.tellg();
+
+            auto& header = *result.header;
+            result.block_size.resize(header.arrays.size());
+            result.blocks.resize(header.arrays.size());
+            for (std::size_t k = 0; k < header.arrays.size(); ++k)
+            {
+                auto& array = header.arrays[k];
+                if (auto const extent =
+                        payloadExtent(header, array, result.size))
+                {
+                    if (auto const hash = hashFileRange(file, extent->first,
+                                                        extent->second))
+                    {
+                        array.has_raw_hash = true;
+                        array.raw_hash = *hash;
+                    }
+                }
+                if (auto const size = readAppendedArraySize(file, header,
+                                                            array))
+                {
+                    array.has_decoded_size = true;
+                    array.decoded_size = *size;
+                }
+                if (header.compressor.empty())
+                    continue;
+
+                // Number of blocks, uncompressed block size, uncompressed
+                // size of the last block and the compressed block sizes.
+                auto const counts =
+                    readAppendedArrayHeaderWords(file, header, array, 3);
+                if (!counts || (*counts)[0] > (1u << 24))
+                    continue;
+                auto const words = readAppendedArrayHeaderWords(
+                    file, header, array, 3 + (*counts)[0]);
+                if (!words)
+                    continue;
+                result.block_size[k] = (*words)[1];
+                result.blocks[k].assign(words->begin() + 3, words->end());
+            }
+        });
+
+    std::string strings;
+    auto const add_string = [&](std::string const& value) {
+        IndexCatalog::String const s{strings.size(), value.size()};
+        strings += value;
+        return s;
+    };
+    std::vector<IndexCatalog::FileRecord> files;
+    std::vector<IndexCatalog::ArrayRecord> arrays;
+    std::vector<std::uint64_t> blocks;
+    for (std::size_t i = 0; i < names.size(); ++i)
+    {
+        auto const& result = scanned[i];
+        if (!result.header)
         {
-            b = vtkSmartPointer<vtkDataArray>{
-                std::get<0>(meshes)->GetCellData()->GetScalars(
-                    data_array_b_name.c_str())};
+            if (args.verbose && !args.quiet)
+                std::cout << "Could not scan the header of file `" << names[i]
+                          << "', not indexed.\n";
+            continue;
+        }
+        auto const& header = *result.header;
+        files.push_back(
+            {add_string(names[i]), result.size, *result.modification_time,
+             add_string(header.byte_order), add_string(header.header_type),
+             add_string(header.compressor),
+             add_string(header.appended_encoding),
+             header.appended_data_position, header.number_of_pieces,
+             header.number_of_points, header.number_of_cells, arrays.size(),
+             header.arrays.size()});
+        for (std::size_t k = 0; k < header.arrays.size(); ++k)
+        {
+            auto const& array = header.arrays[k];
+            std::uint64_t const flags =
+                (array.has_range ? IndexCatalog::has_range : 0) |
+                (array.has_raw_hash ? IndexCatalog::has_raw_hash : 0) |
+                (array.has_decoded_size ? IndexCatalog::has_decoded_size : 0);
+            arrays.push_back(
+                {add_string(array.section), add_string(array.name),
+                 add_string(array.type), add_string(array.format),
+                 array.number_of_components, array.number_of_tuples,
+                 array.offset, array.payload_begin, array.payload_end, flags,
+                 array.range_min, array.range_max, array.raw_hash,
+                 array.decoded_size, result.block_size[k], blocks.size(),
+                 result.blocks[k].size()});
+            blocks.insert(blocks.end(), result.blocks[k].begin(),
+                          result.blocks[k].end());
         }
     }
-    else
+
+    IndexCatalog::Header header{{}, IndexCatalog::version, files.size(),
+                                arrays.size(), blocks.size(), strings.size()};
+    std::memcpy(header.magic, IndexCatalog::magic, sizeof(header.magic));
+
+    auto const path = (std::filesystem::path(directory) /
+                       IndexCatalog::catalog_name)
+                          .string();
+    std::random_device random;
+    auto const temporary_path = path + "." + toHexString(random()) + ".tmp";
     {
-        if (point_data)
+        std::ofstream file(temporary_path, std::ios::binary);
+        file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+        file.write(reinterpret_cast<char const*>(files.data()),
+                   files.size() * sizeof(files[0]));
+        file.write(reinterpret_cast<char const*>(arrays.data()),
+                   arrays.size() * sizeof(arrays[0]));
+        file.write(reinterpret_cast<char const*>(blocks.data()),
+                   blocks.size() * sizeof(blocks[0]));
+        file.write(strings.data(), strings.size());
+        if (!file)
         {
-            b = vtkSmartPointer<vtkDataArray>{
-                std::get<1>(meshes)->GetPointData()->GetScalars(
-                    data_array_b_name.c_str())};
+            file.close();
+            std::filesystem::remove(temporary_path, error);
+            std::cerr << "Error: Could not write the catalog `" << path
+                      << "'.\n";
+            return EXIT_FAILURE;
         }
-        else
+    }
+    std::filesystem::rename(temporary_path, path, error);
+    if (error)
+    {
+        std::filesystem::remove(temporary_path, error);
+        std::cerr << "Error: Could not write the catalog `" << path << "'.\n";
+        return EXIT_FAILURE;
+    }
+
+    if (!args.quiet)
+        std::cout << "Indexed " << files.size() << " files with "
+                  << arrays.size() << " data arrays in `" << path << "'.\n";
+    return EXIT_SUCCESS;
+}
+
+/// Stream buffer discarding everything.
+class NullStreamBuffer : public std::streambuf
+{
+protected:
+    int overflow(int const c) override { return traits_type::not_eof(c); }
+};
+
+/// Stream buffer forwarding everything to another buffer while keeping a
+/// copy of it.
+class RecordingStreamBuffer : public std::streambuf
+{
+public:
+    explicit RecordingStreamBuffer(std::streambuf* const target)
+        : _target(target)
+    {
+    }
+
+    std::string const& recorded() const { return _recorded; }
+
+protected:
+    int overflow(int const c) override
+    {
+        if (traits_type::eq_int_type(c, traits_type::eof()))
         {
-            b = vtkSmartPointer<vtkDataArray>{
-                std::get<1>(meshes)->GetCellData()->GetScalars(
-                    data_array_b_name.c_str())};
+            return traits_type::not_eof(c);
         }
+        _recorded.push_back(traits_type::to_char_type(c));
+        return _target->sputc(traits_type::to_char_type(c));
     }
 
-    if (!b)
+    std::streamsize xsputn(char const* const s,
+                           std::streamsize const n) override
     {
-        std::cerr << "Error: Scalars data array "
-                  << "\'" << data_array_b_name.c_str() << "\'"
-                  << " not found.\n";
-        return std::make_tuple(false, nullptr, nullptr);
+        _recorded.append(s, n);
+        return _target->sputn(s, n);
     }
 
-    return std::make_tuple(true, a, b);
+    int sync() override { return _target->pubsync(); }
+
+private:
+    std::streambuf* const _target;
+    std::string _recorded;
+};
+
+/// Path of the result cache entry for the given inputs and options, or an
+/// empty string if an input file cannot be hashed.
+std::string resultCachePath(Args const& args)
+{
+    // A time series' hash covers the .pvd file and all its steps.
+    auto const hash_input =
+        [](std::string const& filename) -> std::optional<std::uint64_t> {
+        auto hash = hashFile(filename);
+        if (!hash || !stringEndsWith(filename, ".pvd"))
+            return hash;
+        auto const steps = readPvd(filename);
+        if (!steps)
+            return std::nullopt;
+        std::vector<std::uint64_t> hashes{*hash};
+        for (auto const& step : *steps)
+        {
+            auto const step_hash = hashFile(step.filename);
+            if (!step_hash)
+                return std::nullopt;
+            hashes.push_back(*step_hash);
+        }
+        return hashBytes(hashes.data(), hashes.size() * sizeof(hashes[0]));
+    };
+
+    // Writing the ensemble output or a signature is a side effect that must
+    // not be skipped, and measured bandwidths differ between runs.
+    if (!args.ensemble_output.empty() || !args.write_signature.empty() ||
+        args.roofline)
+    {
+        return "";
+    }
+
+    auto const hash_a = hash_input(args.vtk_input_a);
+    auto const hash_b = args.vtk_input_b.empty()
+                            ? std::optional<std::uint64_t>{0}
+                            : hash_input(args.vtk_input_b);
+    if (!hash_a || !hash_b)
+    {
+        return "";
+    }
+
+    // Everything influencing the comparison's output and exit code. The
+    // paths are part of the output's messages.
+    std::stringstream key;
+    key << "vtkdiff-result-1" << '\0' << toHexString(*hash_a) << '\0'
+        << args.vtk_input_b.empty() << toHexString(*hash_b) << '\0'
+        << args.vtk_input_a << '\0' << args.vtk_input_b << '\0'
+        << args.data_array_a << '\0' << args.data_array_b << '\0'
+        << std::hexfloat << args.abs_err_thr << '\0' << args.rel_err_thr
+        << '\0' << args.meshcheck << args.quiet << args.verbose
+        << args.header_check << args.cross_association << '\0'
+        << args.mesh_report << '\0' << args.canonical_node_order
+        << args.mesh_rel_thr << '\0' << args.mesh_rel_scale << '\0'
+        << args.bits << '\0' << args.components << '\0'
+        << args.match_order;
+    for (auto const& member : args.ensemble)
+    {
+        auto const hash = hashFile(member);
+        if (!hash)
+        {
+            return "";
+        }
+        key << '\0' << member << '\0' << toHexString(*hash);
+    }
+    if (!args.against_signature.empty())
+    {
+        auto const hash = hashFile(args.against_signature);
+        if (!hash)
+        {
+            return "";
+        }
+        key << '\0' << "signature" << '\0' << args.against_signature << '\0'
+            << toHexString(*hash);
+    }
+    auto const key_string = key.str();
+
+    return args.result_cache + "/" +
+           toHexString(hashBytes(key_string.data(), key_string.size())) +
+           ".result";
 }
 
-bool compareCellTopology(vtkCellArray* const cells_a,
-                         vtkCellArray* const cells_b)
+/// Writes the output stored in a result cache entry to stdout and stderr and
+/// restores its comparison metrics. Returns the stored exit code, or nothing
+/// if there is no valid entry.
+std::optional<int> replayCachedResult(std::string const& path)
 {
-    vtkIdType const n_cells_a{cells_a->GetNumberOfCells()};
-    vtkIdType const n_cells_b{cells_b->GetNumberOfCells()};
+    std::ifstream file(path, std::ios::binary);
+    std::string magic;
+    int exit_code;
+    std::size_t out_size, err_size;
+    if (!std::getline(file, magic) || magic != "vtkdiff-result 2" ||
+        !(file >> exit_code >> out_size >> err_size) || file.get() != '\n')
+    {
+        return std::nullopt;
+    }
+
+    std::string out(out_size, '\0');
+    std::string err(err_size, '\0');
+    if (!file.read(&out[0], out_size) || !file.read(&err[0], err_size))
+    {
+        return std::nullopt;
+    }
+    auto metrics = Metrics::read(file);
+    if (!metrics)
+    {
+        return std::nullopt;
+    }
+    metrics->result_cache_hit = true;
+    Metrics::instance() = std::move(*metrics);
+    std::cout << out << std::flush;
+    std::cerr << err << std::flush;
+    return exit_code;
+}
+
+/// Stores a result with the comparison metrics atomically, so that
+/// concurrent processes never see a partially written entry. Failures only
+/// lose the cache entry.
+void storeCachedResult(std::string const& path, int const exit_code,
+                       std::string const& out, std::string const& err,
+                       Metrics const& metrics)
+{
+    std::error_code error;
+    std::filesystem::create_directories(
+        std::filesystem::path(path).parent_path(), error);
+
+    std::random_device random;
+    auto const temporary_path = path + "." + toHexString(random()) + ".tmp";
+    {
+        std::ofstream file(temporary_path, std::ios::binary);
+        file << "vtkdiff-result 2\n"
+             << exit_code << " " << out.size() << " " << err.size() << "\n"
+             << out << err;
+        metrics.write(file);
+        if (!file)
+        {
+            file.close();
+            std::filesystem::remove(temporary_path, error);
+            return;
+        }
+    }
+    std::filesystem::rename(temporary_path, path, error);
+    if (error)
+    {
+        std::filesystem::remove(temporary_path, error);
+    }
+}
+
+void printTimings()
+{
+    auto const& perf = PerfCounters::instance();
+    auto const& progress = Progress::instance();
+
+    std::cout << "Timings:\n";
+    if (!perf.enabled())
+    {
+        std::cout << "(hardware performance counters are not available)\n";
+    }
+    auto const print_phase = [&](char const* const name,
+                                 PhaseStatistics const& phase) {
+        std::cout << name << ": " << phase.nanoseconds * 1e-9 << " s, "
+                  << phase.bytes << " bytes\n";
+        if (!perf.enabled())
+        {
+            return;
+        }
+        for (std::size_t i = 0; i < PerfCounters::size; ++i)
+        {
+            std::cout << "  " << PerfCounters::names[i] << " = ";
+            if (perf.available(i))
+                std::cout << phase.counts[i] << "\n";
+            else
+                std::cout << "n/a\n";
+        }
+        double const cycles = phase.counts[0];
+        if (perf.available(0) && cycles > 0)
+        {
+            if (perf.available(1))
+                std::cout << "  IPC = " << phase.counts[1] / cycles << "\n";
+            std::cout << "  bytes/cycle = " << phase.bytes / cycles << "\n";
+        }
+    };
+    print_phase("read", progress.decode);
+    print_phase("compare", progress.compare);
+}
+
+/// Escapes a label value of the OpenMetrics text format.
+std::string escapeLabelValue(std::string const& value)
+{
+    std::string escaped;
+    for (char const c : value)
+    {
+        if (c == '\\' || c == '"')
+            escaped += '\\';
+        if (c == '\n')
+            escaped += "\\n";
+        else
+            escaped += c;
+    }
+    return escaped;
+}
+
+/// Writes the metrics of the run in the OpenMetrics text format. The file is
+/// replaced atomically, so a collector never reads a partial file.
+void writeMetricsFile(std::string const& path, int const exit_code)
+{
+    auto const& progress = Progress::instance();
+    auto const& metrics = Metrics::instance();
+    double const decode_seconds = progress.decode.nanoseconds * 1e-9;
+    double const compare_seconds = progress.compare.nanoseconds * 1e-9;
 
-    if (n_cells_a != n_cells_b)
+    std::uint64_t peak_rss = 0;
+#ifndef _WIN32
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
     {
-        std::cerr << "Number of cells in the first mesh is " << n_cells_a
-                  << " and differs from the number of cells in the second "
-                     "mesh, which is "
-                  << n_cells_b << "\n";
-        return false;
+        // Kilobytes on Linux, bytes on macOS.
+#ifdef __APPLE__
+        peak_rss = usage.ru_maxrss;
+#else
+        peak_rss = static_cast<std::uint64_t>(usage.ru_maxrss) * 1024;
+#endif
     }
+#endif
 
-    vtkIdType n_cell_points_a, n_cell_points_b;
-    #if (VTK_MAJOR_VERSION > 8 || VTK_MINOR_VERSION == 90)
-        const vtkIdType *cell_points_a, *cell_points_b;
-    #else
-        vtkIdType *cell_points_a, *cell_points_b;
-    #endif
-    cells_a->InitTraversal();
-    cells_b->InitTraversal();
-    int get_next_cell_a = cells_a->GetNextCell(n_cell_points_a, cell_points_a);
-    int get_next_cell_b = cells_b->GetNextCell(n_cell_points_b, cell_points_b);
-    int cell_number = 0;
-    while (get_next_cell_a == 1 && get_next_cell_b == 1)
+    std::stringstream out;
+    out << std::setprecision(std::numeric_limits<double>::max_digits10);
+    auto const metric = [&](char const* const name, char const* const type,
+                            char const* const help) {
+        out << "# TYPE " << name << " " << type << "\n"
+            << "# HELP " << name << " " << help << "\n";
+    };
+    metric("vtkdiff_read_bytes", "counter", "Bytes of input files read.");
+    out << "vtkdiff_read_bytes_total " << progress.bytes_total << "\n";
+    metric("vtkdiff_decode_seconds", "gauge",
+           "Time spent reading and decoding input files.");
+    out << "vtkdiff_decode_seconds " << decode_seconds << "\n";
+    metric("vtkdiff_compare_seconds", "gauge",
+           "Time spent comparing data arrays.");
+    out << "vtkdiff_compare_seconds " << compare_seconds << "\n";
+    metric("vtkdiff_compared_tuples", "counter", "Tuples compared.");
+    out << "vtkdiff_compared_tuples_total " << progress.tuples_compared
+        << "\n";
+    metric("vtkdiff_compare_tuples_per_second", "gauge",
+           "Tuples compared per second of compare time.");
+    out << "vtkdiff_compare_tuples_per_second "
+        << (compare_seconds > 0 ? progress.tuples_compared / compare_seconds
+                                : 0)
+        << "\n";
+    metric("vtkdiff_peak_rss_bytes", "gauge", "Peak resident set size.");
+    out << "vtkdiff_peak_rss_bytes " << peak_rss << "\n";
+    metric("vtkdiff_comparisons", "counter", "Data array comparisons.");
+    out << "vtkdiff_comparisons_total " << metrics.comparisons << "\n";
+    metric("vtkdiff_failed_comparisons", "counter",
+           "Data array comparisons exceeding the thresholds.");
+    out << "vtkdiff_failed_comparisons_total " << metrics.failed_comparisons
+        << "\n";
+    metric("vtkdiff_max_abs_error", "gauge",
+           "Maximum absolute error per data array and component.");
+    for (auto const& [name, errors] : metrics.max_errors)
     {
-        if (n_cell_points_a != n_cell_points_b)
+        for (auto const& [component, error] : errors)
         {
-            std::cerr << "Cell " << cell_number << " in first input has "
-                      << n_cell_points_a << " points but in the second input "
-                      << n_cell_points_b << " points.\n";
+            out << "vtkdiff_max_abs_error{array=\"" << escapeLabelValue(name)
+                << "\",component=\"" << component << "\"} "
+                << std::get<0>(error) << "\n";
         }
-
-        for (vtkIdType i = 0; i < n_cell_points_a; ++i)
+    }
+    metric("vtkdiff_max_rel_error", "gauge",
+           "Maximum relative error per data array and component.");
+    for (auto const& [name, errors] : metrics.max_errors)
+    {
+        for (auto const& [component, error] : errors)
         {
-            if (cell_points_a[i] != cell_points_b[i])
-            {
-                std::cerr << "Point " << i << " of cell " << cell_number
-                          << " has id " << cell_points_a[i]
-                          << " in the first input but id " << cell_points_b[i]
-                          << " in the second input.\n";
-                return false;
-            }
+            out << "vtkdiff_max_rel_error{array=\"" << escapeLabelValue(name)
+                << "\",component=\"" << component << "\"} "
+                << std::get<1>(error) << "\n";
         }
-
-        get_next_cell_a = cells_a->GetNextCell(n_cell_points_a, cell_points_a);
-        get_next_cell_b = cells_b->GetNextCell(n_cell_points_b, cell_points_b);
-        cell_number++;
     }
+    metric("vtkdiff_passed", "gauge",
+           "1 if the comparison passed, 0 otherwise.");
+    out << "vtkdiff_passed " << (exit_code == EXIT_SUCCESS ? 1 : 0) << "\n";
+    metric("vtkdiff_result_cache_hit", "gauge",
+           "1 if the result was taken from the result cache, 0 otherwise.");
+    out << "vtkdiff_result_cache_hit " << (metrics.result_cache_hit ? 1 : 0)
+        << "\n";
+    out << "# EOF\n";
 
-    if (get_next_cell_a != 0)
+    std::error_code error;
+    std::random_device random;
+    auto const temporary_path = path + "." + toHexString(random()) + ".tmp";
     {
-        std::cerr << "Unexpected return value (" << get_next_cell_a
-                  << ") for cells_a->GetNextCell() call. Expected 0 for "
-                     "end-of-list or 1 for no error.\n";
-        return false;
+        std::ofstream file(temporary_path, std::ios::binary);
+        file << out.str();
+        if (!file)
+        {
+            file.close();
+            std::filesystem::remove(temporary_path, error);
+            std::cerr << "Error: Could not write metrics file `" << path
+                      << "'.\n";
+            return;
+        }
     }
-    if (get_next_cell_b != 0)
+    std::filesystem::rename(temporary_path, path, error);
+    if (error)
     {
-        std::cerr << "Unexpected return value (" << get_next_cell_b
-                  << ") for cells_b->GetNextCell() call. Expected 0 for "
-                     "end-of-list or 1 for no error.\n";
-        return false;
+        std::filesystem::remove(temporary_path, error);
+        std::cerr << "Error: Could not write metrics file `" << path
+                  << "'.\n";
     }
-
-    return true;
 }
 
-bool comparePoints(vtkPoints* const points_a, vtkPoints* const points_b,
-                   double const eps_squared)
+int runComparison(Args const& args)
 {
-    vtkIdType const n_points_a{points_a->GetNumberOfPoints()};
-    vtkIdType const n_points_b{points_b->GetNumberOfPoints()};
-
-    if (n_points_a != n_points_b)
+    if (!args.write_signature.empty() || !args.against_signature.empty())
     {
-        std::cerr << "Number of points in the first mesh is " << n_points_a
-                  << " and differst from the number of point in the second "
-                     "mesh, which is "
-                  << n_points_b << "\n";
-        return false;
+        if (!args.write_signature.empty() && !args.against_signature.empty())
+        {
+            std::cerr << "Error: --write-signature and --against-signature "
+                         "cannot be combined.\n";
+            return EXIT_FAILURE;
+        }
+        if (args.meshcheck || !args.ensemble.empty() || args.match_order ||
+            !stringEndsWith(args.vtk_input_a, ".vtu"))
+        {
+            std::cerr << "Error: Signatures are supported for data arrays of "
+                         "single .vtu files only.\n";
+            return EXIT_FAILURE;
+        }
+        return args.write_signature.empty() ? compareToSignature(args)
+                                            : writeSignatures(args);
     }
-
-    for (vtkIdType p = 0; p < n_points_a; ++p)
+    if (stringEndsWith(args.vtk_input_a, ".pvd"))
     {
-        auto const a = points_a->GetPoint(p);
-        auto const b = points_b->GetPoint(p);
-        double const distance2 = vtkMath::Distance2BetweenPoints(a, b);
-        if (distance2 >= eps_squared)
+        if (!args.ensemble.empty())
         {
-            std::cerr << "Point " << p << " with coordinates (" << a[0] << ", "
-                      << a[1] << ", " << a[2]
-                      << ") from the first mesh is significantly different "
-                         "from the same point in the second mesh, which "
-                         "has coordinates ("
-                      << b[0] << ", " << b[1] << ", " << b[2]
-                      << ") with distance between them " << std::sqrt(distance2)
-                      << "\n";
-            return false;
+            std::cerr << "Error: Ensembles of time series are not supported.\n";
+            return EXIT_FAILURE;
         }
+        return compareTimeSeries(args);
+    }
+    if (!args.ensemble.empty())
+    {
+        return compareEnsemble(args);
     }
-    return true;
-}
-
-int main(int argc, char* argv[])
-{
-    auto const digits10 = std::numeric_limits<double>::digits10;
-    auto const args = parseCommandLine(argc, argv);
-
-    // Setup the standard output and error stream numerical formats.
-    std::cout << std::scientific << std::setprecision(digits10);
-    std::cerr << std::scientific << std::setprecision(digits10);
 
-    auto meshes = readMeshes(args.vtk_input_a, args.vtk_input_b);
+    if (args.match_order && args.shm_cache)
+    {
+        std::cerr << "Error: --match-order cannot be combined with "
+                     "--shm-cache.\n";
+        return EXIT_FAILURE;
+    }
 
     if (args.meshcheck)
     {
+        auto meshes =
+            readMeshes(args.vtk_input_a, args.vtk_input_b, {}, {});
+
         if (args.vtk_input_a == args.vtk_input_b)
         {
             std::cout << "Will not compare meshes from same input file.\n";
             return EXIT_SUCCESS;
         }
-        if (!comparePoints(std::get<0>(meshes)->GetPoints(),
-                           std::get<1>(meshes)->GetPoints(),
-                           args.abs_err_thr * args.abs_err_thr))
+        return compareMeshes(args, std::get<0>(meshes), std::get<1>(meshes))
+                   ? EXIT_SUCCESS
+                   : EXIT_FAILURE;
+    }
+
+    if (args.header_check)
+    {
+        if (auto const exit_code = precheckDataArrayHeaders(args))
         {
-            std::cerr << "Error in mesh points' comparison occured.\n";
-            return EXIT_FAILURE;
+            return *exit_code;
         }
+    }
 
-        if (!compareCellTopology(std::get<0>(meshes)->GetCells(),
-                                 std::get<1>(meshes)->GetCells()))
+    // Identical payloads are not decoded unless the values are needed.
+    auto const n_components =
+        args.header_check && !args.shm_cache && !args.match_order &&
+                !args.bits && !args.roofline
+            ? identicalIndexedPayloads(args)
+            : std::nullopt;
+    if (n_components &&
+        (args.components.empty() || args.components.back() < *n_components))
+    {
+        auto components = args.components;
+        if (components.empty())
         {
-            std::cerr << "Error in cells' topology comparison occured.\n";
-            return EXIT_FAILURE;
+            components.resize(*n_components);
+            std::iota(components.begin(), components.end(), 0);
         }
+
+        if (!args.quiet)
+            std::cout << "Comparing data array `" << args.data_array_a
+                      << "' from file `" << args.vtk_input_a
+                      << "' to data array `" << args.data_array_b
+                      << "' from file `" << args.vtk_input_b << "'.\n";
+        if (args.verbose && !args.quiet)
+            std::cout << "The catalogs show identical payloads, the data "
+                         "arrays are not decoded.\n";
+
+        ErrorNorms const norms(components.size());
+        Metrics::instance().addComparison(args.data_array_a, components,
+                                          norms, false);
+        if (!args.quiet)
+            printErrorNorms(norms);
         return EXIT_SUCCESS;
     }
 
@@ -466,159 +7360,313 @@ int main(int argc, char* argv[])
     bool read_successful;
     vtkSmartPointer<vtkDataArray> a;
     vtkSmartPointer<vtkDataArray> b;
+    std::tuple<vtkSmartPointer<vtkUnstructuredGrid>,
+               vtkSmartPointer<vtkUnstructuredGrid>>
+        meshes;
 
-    std::tie(read_successful, a, b) =
-        readDataArraysFromMeshes(meshes, args.data_array_a, args.data_array_b);
+    if (args.shm_cache)
+    {
+        std::tie(read_successful, a, b) =
+            readDataArraysWithSharedMemoryCache(args);
+    }
+    else
+    {
+        meshes = readMeshes(args.vtk_input_a, args.vtk_input_b,
+                            dataArraysToRead(args, true),
+                            dataArraysToRead(args, false));
+        std::tie(read_successful, a, b) = readDataArraysFromMeshes(
+            meshes, args.data_array_a, args.data_array_b,
+            args.cross_association);
+    }
 
     if (!read_successful)
         return EXIT_FAILURE;
 
+    if (args.match_order && !args.vtk_input_b.empty())
+    {
+        auto* const mesh_a = std::get<0>(meshes).Get();
+        bool const point_data =
+            mesh_a->GetPointData()->HasArray(args.data_array_a.c_str()) != 0;
+        b = matchDataArray(args, mesh_a, std::get<1>(meshes), *b, point_data);
+        if (!b)
+            return EXIT_FAILURE;
+    }
+
     if (!args.quiet)
         std::cout << "Comparing data array `" << args.data_array_a
                   << "' from file `" << args.vtk_input_a << "' to data array `"
                   << args.data_array_b << "' from file `" << args.vtk_input_b
                   << "'.\n";
 
-    // Check similarity of the data arrays.
-
-    // Is numeric
-    if (!a->IsNumeric())
+    if (!checkDataArrayShapes(*a, *b) || !checkSelectedComponents(args, *a))
     {
-        std::cerr << "Data in data array a is not numeric:\n"
-                  << "data type is " << a->GetDataTypeAsString() << "\n";
-
         return EXIT_FAILURE;
     }
-    if (!b->IsNumeric())
+
+    auto const norms = computeErrorNorms(*a, *b, args);
+    Metrics::instance().addComparison(args.data_array_a,
+                                      selectedComponents(args, *a), norms,
+                                      norms.exceedThresholds(args));
+
+    // Error information
+    if (!args.quiet)
     {
-        std::cerr << "Data in data array b is not numeric.\n"
-                  << "data type is " << b->GetDataTypeAsString() << "\n";
-        return EXIT_FAILURE;
+        printErrorNorms(norms);
+        if (args.bits)
+        {
+            auto const components = selectedComponents(args, *a);
+            printBitDifferences(computeBitDifferences(*a, *b, components),
+                                components);
+        }
+        if (args.roofline)
+        {
+            printRoofline(*a, *b, selectedComponents(args, *a));
+        }
     }
 
-    auto const num_tuples = a->GetNumberOfTuples();
-    // Number of components
-    if (num_tuples != b->GetNumberOfTuples())
+    if (norms.exceedThresholds(args))
     {
-        std::cerr << "Number of tuples differ:\n"
-                  << num_tuples << " in data array a and "
-                  << b->GetNumberOfTuples() << " in data array b\n";
+        if (!args.quiet)
+            std::cout << "Absolute and relative error (maximum norm) are larger"
+                         " than the corresponding thresholds "
+                      << args.abs_err_thr << " and " << args.rel_err_thr
+                      << ".\n";
         return EXIT_FAILURE;
     }
 
-    auto const num_components = a->GetNumberOfComponents();
-    // Number of components
-    if (num_components != b->GetNumberOfComponents())
+    return EXIT_SUCCESS;
+}
+
+/// All files read by a comparison, including the steps of time series.
+std::vector<std::string> inputFiles(Args const& args)
+{
+    std::vector<std::string> files;
+    for (auto const& filename : {args.vtk_input_a, args.vtk_input_b})
     {
-        std::cerr << "Number of components differ:\n"
-                  << num_components << " in data array a and "
-                  << b->GetNumberOfComponents() << " in data array b\n";
-        return EXIT_FAILURE;
+        if (filename.empty())
+            continue;
+        files.push_back(filename);
+        if (!stringEndsWith(filename, ".pvd"))
+            continue;
+        if (auto const steps = readPvd(filename))
+        {
+            for (auto const& step : *steps)
+                files.push_back(step.filename);
+        }
     }
+    files.insert(files.end(), args.ensemble.begin(), args.ensemble.end());
+    return files;
+}
 
-    // Calculate difference of the data arrays.
-
-    // Absolute error and norms.
-    std::vector<double> abs_err_norm_l1(num_components);
-    std::vector<double> abs_err_norm_2_2(num_components);
-    std::vector<double> abs_err_norm_max(num_components);
+/// Asks the operating system to drop the cached pages of the file. Returns
+/// false if this is not supported.
+bool evictFromPageCache(std::string const& filename)
+{
+#ifdef POSIX_FADV_DONTNEED
+    int const fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    int const result = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+    return result == 0;
+#else
+    (void)filename;
+    return false;
+#endif
+}
 
-    // Relative error and norms.
-    std::vector<double> rel_err_norm_l1(num_components);
-    std::vector<double> rel_err_norm_2_2(num_components);
-    std::vector<double> rel_err_norm_max(num_components);
+/// Runs the comparison args.repeat times and prints the minimum, median and
+/// maximum times of its phases. Output, progress counters and metrics of all
+/// but the first run are discarded, so that --timings and --metrics-file
+/// describe a single comparison. Returns the exit code of the first run.
+int runRepeated(Args const& args)
+{
+    auto& progress = Progress::instance();
+    Progress first_progress;
+    Metrics first_metrics;
+    std::vector<double> read_seconds, compare_seconds, total_seconds;
+    bool evicted = true;
+    int exit_code = EXIT_SUCCESS;
 
-    for (auto tuple_idx = 0; tuple_idx < num_tuples; ++tuple_idx)
+    NullStreamBuffer null_buffer;
+    for (int run = 0; run < args.repeat; ++run)
     {
-        for (auto component_idx = 0; component_idx < num_components;
-             ++component_idx)
+        if (args.evict_page_cache)
         {
-            auto const a_comp = a->GetComponent(tuple_idx, component_idx);
-            auto const b_comp = b->GetComponent(tuple_idx, component_idx);
-            auto const abs_err = std::abs(a_comp - b_comp);
+            for (auto const& filename : inputFiles(args))
+                evicted = evictFromPageCache(filename) && evicted;
+        }
 
-            abs_err_norm_l1[component_idx] += abs_err;
-            abs_err_norm_2_2[component_idx] += abs_err * abs_err;
-            abs_err_norm_max[component_idx] =
-                std::max(abs_err_norm_max[component_idx], abs_err);
+        std::int64_t const read_start = progress.decode.nanoseconds;
+        std::int64_t const compare_start = progress.compare.nanoseconds;
+        auto const start = std::chrono::steady_clock::now();
 
-            // relative error and its norms:
-            double rel_err;
+        if (run == 0)
+        {
+            exit_code = runComparison(args);
+            first_progress.assign(progress);
+            first_metrics = Metrics::instance();
+        }
+        else
+        {
+            auto* const cout_buffer = std::cout.rdbuf(&null_buffer);
+            auto* const cerr_buffer = std::cerr.rdbuf(&null_buffer);
+            runComparison(args);
+            std::cout.rdbuf(cout_buffer);
+            std::cerr.rdbuf(cerr_buffer);
+        }
 
-            if (abs_err == 0.0)
-            {
-                rel_err = 0.0;
-            }
-            else if (a_comp == 0.0 || b_comp == 0.0)
-            {
-                rel_err = std::numeric_limits<double>::infinity();
-            }
-            else
-            {
-                rel_err =
-                    abs_err / std::min(std::abs(a_comp), std::abs(b_comp));
-            }
+        total_seconds.push_back(std::chrono::duration<double>(
+                                    std::chrono::steady_clock::now() - start)
+                                    .count());
+        read_seconds.push_back((progress.decode.nanoseconds - read_start) *
+                               1e-9);
+        compare_seconds.push_back(
+            (progress.compare.nanoseconds - compare_start) * 1e-9);
+    }
+    progress.assign(first_progress);
+    Metrics::instance() = first_metrics;
+
+    if (args.quiet)
+    {
+        return exit_code;
+    }
+    if (args.evict_page_cache && !evicted)
+    {
+        std::cerr << "Warning: Could not evict all input files from the page "
+                     "cache.\n";
+    }
+    std::cout << "Timings of " << args.repeat << " runs"
+              << (args.evict_page_cache ? " with evicted page cache" : "")
+              << ":\n";
+    auto const print_phase = [](char const* const name,
+                                std::vector<double> seconds) {
+        std::sort(seconds.begin(), seconds.end());
+        auto const n = seconds.size();
+        double const median =
+            n % 2 == 1 ? seconds[n / 2]
+                       : 0.5 * (seconds[n / 2 - 1] + seconds[n / 2]);
+        std::cout << name << "min " << seconds.front() << " s, median "
+                  << median << " s, max " << seconds.back() << " s\n";
+    };
+    print_phase("read:    ", read_seconds);
+    print_phase("compare: ", compare_seconds);
+    print_phase("total:   ", total_seconds);
+    return exit_code;
+}
 
-            rel_err_norm_l1[component_idx] += rel_err;
-            rel_err_norm_2_2[component_idx] += rel_err * rel_err;
-            rel_err_norm_max[component_idx] =
-                std::max(rel_err_norm_max[component_idx], rel_err);
+/// Runs the action selected on the command line. Returns the exit code.
+int run(Args const& args)
+{
+    ioBackend() = args.io == "mmap"    ? IoBackend::mmap
+                  : args.io == "pread"   ? IoBackend::pread
+                  : args.io == "direct"  ? IoBackend::direct
+                                         : IoBackend::buffered;
 
-            if (abs_err > args.abs_err_thr && rel_err > args.rel_err_thr &&
-                args.verbose)
-            {
-                std::cout << "tuple: " << std::setw(4) << tuple_idx
-                          << "component: " << std::setw(2) << component_idx
-                          << ": abs err = " << std::setw(digits10 + 7)
-                          << abs_err
-                          << ", rel err = " << std::setw(digits10 + 7)
-                          << rel_err << "\n";
-            }
-        }
+    if (args.repeat < 1)
+    {
+        std::cerr << "Error: The number of repetitions must be positive.\n";
+        return EXIT_FAILURE;
     }
 
-    // Error information
-    if (!args.quiet)
+    if (args.mesh_report < 0)
+    {
+        std::cerr << "Error: The number of reported mesh mismatches must not "
+                     "be negative.\n";
+        return EXIT_FAILURE;
+    }
+
+    if (!args.permutation_cache.empty() && !args.match_order)
+    {
+        std::cerr << "Error: --permutation-cache requires --match-order.\n";
+        return EXIT_FAILURE;
+    }
+
+    if (args.index)
+    {
+        return writeIndex(args);
+    }
+
+    // Repeated runs measure the comparison and are never cached.
+    std::string result_cache_path;
+    if (!args.result_cache.empty() && args.repeat == 1)
     {
-        std::cout << "Computed difference between data arrays:\n";
-        std::cout << "abs l1 norm      = " << abs_err_norm_l1 << "\n";
-        std::cout << "abs l2-norm^2    = " << abs_err_norm_2_2 << "\n";
+        result_cache_path = resultCachePath(args);
+        if (auto const exit_code = replayCachedResult(result_cache_path))
+        {
+            return *exit_code;
+        }
+    }
 
-        // temporary squared norm vector for output.
-        std::vector<double> abs_err_norm_2;
-        std::transform(std::begin(abs_err_norm_2_2), std::end(abs_err_norm_2_2),
-                       std::back_inserter(abs_err_norm_2),
-                       [](double x) { return std::sqrt(x); });
-        std::cout << "abs l2-norm      = " << abs_err_norm_2 << "\n";
+    if (args.max_memory > 0 && !admitMemoryFootprint(args))
+    {
+        return EXIT_FAILURE;
+    }
 
-        std::cout << "abs maximum norm = " << abs_err_norm_max << "\n";
-        std::cout << "\n";
+    std::optional<ProgressReporter> progress_reporter;
+    if (args.progress)
+    {
+        progress_reporter.emplace();
+    }
+    if (args.timings)
+    {
+        PerfCounters::instance().open();
+    }
 
-        std::cout << "rel l1 norm      = " << rel_err_norm_l1 << "\n";
-        std::cout << "rel l2-norm^2    = " << rel_err_norm_2_2 << "\n";
+    int exit_code;
+    if (args.repeat > 1)
+    {
+        exit_code = runRepeated(args);
+    }
+    else if (result_cache_path.empty())
+    {
+        exit_code = runComparison(args);
+    }
+    else
+    {
+        RecordingStreamBuffer recorded_cout(std::cout.rdbuf());
+        RecordingStreamBuffer recorded_cerr(std::cerr.rdbuf());
+        auto* const cout_buffer = std::cout.rdbuf(&recorded_cout);
+        auto* const cerr_buffer = std::cerr.rdbuf(&recorded_cerr);
 
-        // temporary squared norm vector for output.
-        std::vector<double> rel_err_norm_2;
-        std::transform(std::begin(rel_err_norm_2_2), std::end(rel_err_norm_2_2),
-                       std::back_inserter(rel_err_norm_2),
-                       [](double x) { return std::sqrt(x); });
-        std::cout << "rel l2-norm      = " << rel_err_norm_2_2 << "\n";
+        exit_code = runComparison(args);
 
-        std::cout << "rel maximum norm = " << rel_err_norm_max << "\n";
+        std::cout.rdbuf(cout_buffer);
+        std::cerr.rdbuf(cerr_buffer);
+        storeCachedResult(result_cache_path, exit_code,
+                          recorded_cout.recorded(), recorded_cerr.recorded(),
+                          Metrics::instance());
     }
 
-    if (*std::max_element(abs_err_norm_max.begin(), abs_err_norm_max.end()) >
-            args.abs_err_thr &&
-        *std::max_element(rel_err_norm_max.begin(), rel_err_norm_max.end()) >
-            args.rel_err_thr)
+    if (args.timings)
     {
-        if (!args.quiet)
-            std::cout << "Absolute and relative error (maximum norm) are larger"
-                         " than the corresponding thresholds "
-                      << args.abs_err_thr << " and " << args.rel_err_thr
-                      << ".\n";
-        return EXIT_FAILURE;
+        printTimings();
     }
+    return exit_code;
+}
 
-    return EXIT_SUCCESS;
+int main(int argc, char* argv[])
+{
+    auto const digits10 = std::numeric_limits<double>::digits10;
+    auto const args = parseCommandLine(argc, argv);
+
+    // Setup the standard output and error stream numerical formats.
+    std::cout << std::scientific << std::setprecision(digits10);
+    std::cerr << std::scientific << std::setprecision(digits10);
+
+    // The metrics file is written however the run ends.
+    static std::string metrics_file;
+    metrics_file = args.metrics_file;
+    exitHandler() = [](int const exit_code) {
+        if (!metrics_file.empty())
+        {
+            writeMetricsFile(metrics_file, exit_code);
+        }
+    };
+
+    int const exit_code = run(args);
+    exitHandler()(exit_code);
+    return exit_code;
 }